@@ -0,0 +1,253 @@
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <optional>
+#include <stdexcept>
+
+#include "benchmark.hpp"
+
+namespace {
+std::atomic<size_t> allocation_count{};
+std::atomic<size_t> allocated_bytes{};
+
+void *allocate(size_t size, size_t alignment) {
+  allocation_count.fetch_add(1, std::memory_order_relaxed);
+  allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+  if (size == 0) {
+    size = 1;
+  }
+  void *memory = nullptr;
+  if (alignment <= alignof(std::max_align_t)) {
+    memory = std::malloc(size);
+  } else {
+    // aligned_alloc wants a multiple of the alignment
+    memory = std::aligned_alloc(alignment,
+                                (size + alignment - 1) / alignment * alignment);
+  }
+  if (memory == nullptr) {
+    throw std::bad_alloc();
+  }
+  return memory;
+}
+} // namespace
+
+// every allocation of the process goes through these, so that the cases can
+// count what the wrappers allocate
+void *operator new(size_t size) {
+  return allocate(size, alignof(std::max_align_t));
+}
+void *operator new(size_t size, std::align_val_t alignment) {
+  return allocate(size, static_cast<size_t>(alignment));
+}
+void operator delete(void *memory) noexcept { std::free(memory); }
+void operator delete(void *memory, std::align_val_t) noexcept {
+  std::free(memory);
+}
+void operator delete(void *memory, size_t) noexcept { std::free(memory); }
+void operator delete(void *memory, size_t, std::align_val_t) noexcept {
+  std::free(memory);
+}
+
+namespace benchmark {
+
+namespace {
+struct registered_case {
+  std::string name;
+  setup_function setup;
+};
+
+std::vector<registered_case> &get_cases() {
+  static std::vector<registered_case> cases;
+  return cases;
+}
+
+// no case runs more often, however fast it is
+constexpr size_t max_iterations = 1'000'000'000;
+
+std::optional<result> measure(const std::string &name, const fixture &f,
+                              const run_options &options) {
+  // the first call creates what is created lazily, e.g. links the program
+  if (!f.run(1)) {
+    return {};
+  }
+  if (options.synchronize) {
+    options.synchronize();
+  }
+
+  using clock = std::chrono::steady_clock;
+  size_t iterations = 1;
+  for (;;) {
+    auto const allocations_before = allocation_count.load();
+    auto const bytes_before = allocated_bytes.load();
+    auto const cpu_begin = std::clock();
+    auto const begin = clock::now();
+    if (!f.run(iterations)) {
+      return {};
+    }
+    if (options.synchronize) {
+      options.synchronize();
+    }
+    auto const seconds =
+        std::chrono::duration<double>(clock::now() - begin).count();
+    auto const cpu_seconds =
+        static_cast<double>(std::clock() - cpu_begin) / CLOCKS_PER_SEC;
+
+    if (seconds >= options.min_seconds || iterations >= max_iterations) {
+      auto const n = static_cast<double>(iterations);
+      result r;
+      r.name = name;
+      r.iterations = iterations;
+      r.real_nanoseconds = seconds * 1e9 / n;
+      r.cpu_nanoseconds = cpu_seconds * 1e9 / n;
+      if (f.bytes_per_iteration != 0 && seconds > 0) {
+        r.bytes_per_second =
+            static_cast<double>(f.bytes_per_iteration) * n / seconds;
+      }
+      r.allocations =
+          static_cast<double>(allocation_count.load() - allocations_before) /
+          n;
+      r.allocated_bytes =
+          static_cast<double>(allocated_bytes.load() - bytes_before) / n;
+      if (f.counters) {
+        r.counters = f.counters();
+      }
+      return r;
+    }
+    // aim a little past the minimum time, growing at most 100 times
+    auto const estimate =
+        seconds > 0 ? options.min_seconds * 1.2 / seconds *
+                          static_cast<double>(iterations)
+                    : static_cast<double>(iterations) * 100;
+    iterations = std::clamp(static_cast<size_t>(estimate), iterations * 2,
+                            iterations * 100);
+    iterations = std::min(iterations, max_iterations);
+  }
+}
+
+std::string escape(const std::string &text) {
+  std::string escaped;
+  for (auto c : text) {
+    if (c == '"' || c == '\\') {
+      escaped.push_back('\\');
+    }
+    escaped.push_back(c);
+  }
+  return escaped;
+}
+} // namespace
+
+void add(std::string name, setup_function setup) {
+  get_cases().push_back({std::move(name), std::move(setup)});
+}
+
+std::vector<std::string> get_names() {
+  std::vector<std::string> names;
+  for (auto const &c : get_cases()) {
+    names.push_back(c.name);
+  }
+  return names;
+}
+
+bool run(const run_options &options, std::vector<result> &results) {
+  bool succeeded = true;
+  for (auto const &c : get_cases()) {
+    if (c.name.find(options.filter) == std::string::npos) {
+      continue;
+    }
+    std::optional<result> r;
+    try {
+      auto const f = c.setup();
+      r = measure(c.name, f, options);
+    } catch (const std::exception &e) {
+      std::cerr << c.name << " setup failed:" << e.what() << std::endl;
+    }
+    if (!r) {
+      std::cerr << c.name << " failed" << std::endl;
+      succeeded = false;
+      continue;
+    }
+    print(std::cout, {*r});
+    results.push_back(std::move(*r));
+  }
+  return succeeded;
+}
+
+void print(std::ostream &out, const std::vector<result> &results) {
+  for (auto const &r : results) {
+    out << std::left << std::setw(48) << r.name << std::right << std::fixed
+        << std::setprecision(1) << std::setw(14) << r.real_nanoseconds
+        << " ns" << std::setw(12) << r.iterations << std::setprecision(2)
+        << std::setw(10) << r.allocations << " allocs";
+    if (r.bytes_per_second > 0) {
+      out << std::setw(14) << r.bytes_per_second / (1 << 20) << " MiB/s";
+    }
+    out << std::defaultfloat;
+    for (auto const &[name, value] : r.counters) {
+      out << " " << name << "=" << value;
+    }
+    out << std::endl;
+  }
+}
+
+bool write_json(const std::filesystem::path &file,
+                const std::vector<result> &results,
+                const std::string &backend) {
+  std::ofstream out(file);
+  if (!out) {
+    std::cerr << "open " << file << " failed" << std::endl;
+    return false;
+  }
+  char date[32]{};
+  auto const now = std::time(nullptr);
+  std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+
+  out << std::setprecision(17);
+  out << "{\n  \"context\": {\n"
+      << "    \"date\": \"" << date << "\",\n"
+      << "    \"backend\": \"" << escape(backend) << "\",\n"
+#ifdef NDEBUG
+      << "    \"library_build_type\": \"release\"\n"
+#else
+      << "    \"library_build_type\": \"debug\"\n"
+#endif
+      << "  },\n  \"benchmarks\": [";
+  for (size_t i = 0; i < results.size(); i++) {
+    auto const &r = results[i];
+    out << (i == 0 ? "\n" : ",\n") << "    {\n"
+        << "      \"name\": \"" << escape(r.name) << "\",\n"
+        << "      \"run_name\": \"" << escape(r.name) << "\",\n"
+        << "      \"run_type\": \"iteration\",\n"
+        << "      \"iterations\": " << r.iterations << ",\n"
+        << "      \"real_time\": " << r.real_nanoseconds << ",\n"
+        << "      \"cpu_time\": " << r.cpu_nanoseconds << ",\n"
+        << "      \"time_unit\": \"ns\",\n";
+    if (r.bytes_per_second > 0) {
+      out << "      \"bytes_per_second\": " << r.bytes_per_second << ",\n";
+    }
+    for (auto const &[name, value] : r.counters) {
+      out << "      \"" << escape(name) << "\": " << value << ",\n";
+    }
+    out << "      \"items_per_second\": "
+        << (r.real_nanoseconds > 0 ? 1e9 / r.real_nanoseconds : 0.0) << ",\n"
+        << "      \"allocations_per_iteration\": " << r.allocations << ",\n"
+        << "      \"allocated_bytes_per_iteration\": " << r.allocated_bytes
+        << "\n    }";
+  }
+  out << "\n  ]\n}\n";
+  if (!out) {
+    std::cerr << "write " << file << " failed" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+} // namespace benchmark
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <functional>
+#include <iosfwd>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace benchmark {
+
+// A prepared case. run performs the measured operation iterations times and
+// returns false if it failed.
+struct fixture {
+  std::function<bool(size_t iterations)> run;
+  // bytes processed per iteration, 0 when throughput means nothing
+  size_t bytes_per_iteration{};
+  // named values describing the last iteration, e.g. triangle counts,
+  // reported next to the time
+  std::function<std::vector<std::pair<std::string, double>>()> counters{};
+};
+
+// Creates the objects a case needs; called right before the case runs, and
+// the fixture is destroyed right after it. Throw to report a broken setup.
+using setup_function = std::function<fixture()>;
+
+struct result {
+  std::string name;
+  size_t iterations{};
+  double real_nanoseconds{};
+  double cpu_nanoseconds{};
+  double bytes_per_second{};
+  // operator new calls and bytes, including those of the library and the
+  // driver
+  double allocations{};
+  double allocated_bytes{};
+  std::vector<std::pair<std::string, double>> counters;
+};
+
+struct run_options {
+  // a case runs until it took at least this long
+  double min_seconds{0.2};
+  // only the cases whose name contains it
+  std::string filter;
+  // waits for the commands issued by a run to finish, e.g. glFinish
+  std::function<void()> synchronize;
+};
+
+void add(std::string name, setup_function setup);
+std::vector<std::string> get_names();
+
+// false if a case failed; the results of the others are still appended
+bool run(const run_options &options, std::vector<result> &results);
+
+void print(std::ostream &out, const std::vector<result> &results);
+// in the format of Google Benchmark's --benchmark_format=json, so that its
+// comparison tools read the results; the per-iteration allocation counts and
+// the counters are additional fields of each entry
+bool write_json(const std::filesystem::path &file,
+                const std::vector<result> &results,
+                const std::string &backend);
+
+} // namespace benchmark
@@ -0,0 +1,586 @@
+
+#include <array>
+#include <cstdlib>
+#include <initializer_list>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "benchmark.hpp"
+#include "camera.hpp"
+#include "context.hpp"
+#include "mesh.hpp"
+#include "model.hpp"
+#include "null_backend.hpp"
+#include "program.hpp"
+#include "synthetic_assets.hpp"
+#include "uniform_buffer.hpp"
+#include "vertex_array.hpp"
+
+namespace {
+using texture_variable_names =
+    std::map<opengl::texture_2D::type, std::vector<std::string>>;
+
+// the synthetic models and images are written here
+std::filesystem::path asset_directory;
+
+// a program built from benchmark::make_shader_sources with every uniform
+// assigned, as use() expects in debug builds
+struct scene {
+  std::unique_ptr<opengl::program> prog;
+  std::vector<opengl::texture_2D> textures;
+};
+
+std::shared_ptr<scene> make_scene(size_t textures, size_t blocks) {
+  if (opengl::null_backend::is_installed()) {
+    opengl::null_backend::set_program_interface(
+        benchmark::make_program_interface(textures, blocks));
+  }
+  auto s = std::make_shared<scene>();
+  s->prog = std::make_unique<opengl::program>();
+  auto &prog = *s->prog;
+  auto const sources = benchmark::make_shader_sources(textures, blocks);
+  if (!prog.attach_shader(GL_VERTEX_SHADER, sources.vertex) ||
+      !prog.attach_shader(GL_FRAGMENT_SHADER, sources.fragment)) {
+    throw std::runtime_error("attach_shader failed");
+  }
+
+  bool assigned =
+      prog.set_uniform("scale", 1.0f) && prog.set_uniform("mode", GLint(0)) &&
+      prog.set_uniform("tint", glm::vec3(1.0f)) &&
+      prog.set_uniform("offset", 0.0f, 0.0f, 0.0f) &&
+      prog.set_uniform("cell", GLint(0), GLint(0), GLint(0)) &&
+      prog.set_uniform("model", glm::mat4(1.0f)) &&
+      prog.set_uniform("view_projection", glm::mat4(1.0f));
+  for (size_t i = 0; i < textures && assigned; i++) {
+    s->textures.emplace_back(4, 4, GL_RGBA8);
+    assigned = prog.set_uniform("texture" + std::to_string(i),
+                                s->textures.back());
+  }
+  for (size_t i = 0; i < blocks && assigned; i++) {
+    auto const suffix = std::to_string(i);
+    assigned = prog.set_uniform_of_block("block" + suffix, "color" + suffix,
+                                         glm::vec4(1.0f)) &&
+               prog.set_uniform_of_block("block" + suffix,
+                                         "transform" + suffix,
+                                         glm::mat4(1.0f));
+  }
+  if (!assigned) {
+    throw std::runtime_error("assign uniforms failed");
+  }
+  return s;
+}
+
+// calls operation(i) for each iteration i
+template <typename operation_type>
+std::function<bool(size_t)> repeat(operation_type operation) {
+  return [operation](size_t iterations) mutable {
+    for (size_t i = 0; i < iterations; i++) {
+      if (!operation(i)) {
+        return false;
+      }
+    }
+    return true;
+  };
+}
+
+void add_set_uniform_cases() {
+  // the values change every iteration, as per-object uniforms do
+  auto add_case = [](const std::string &name, auto set) {
+    benchmark::add("set_uniform/" + name, [set] {
+      auto s = make_scene(0, 0);
+      return benchmark::fixture{
+          repeat([s, set](size_t i) { return set(*s->prog, i); })};
+    });
+  };
+  add_case("GLint", [](opengl::program &prog, size_t i) {
+    return prog.set_uniform("mode", static_cast<GLint>(i));
+  });
+  add_case("GLfloat", [](opengl::program &prog, size_t i) {
+    return prog.set_uniform("scale", static_cast<GLfloat>(i));
+  });
+  add_case("vec3", [](opengl::program &prog, size_t i) {
+    return prog.set_uniform("tint", glm::vec3(static_cast<float>(i)));
+  });
+  add_case("mat4", [](opengl::program &prog, size_t i) {
+    return prog.set_uniform("model", glm::mat4(static_cast<float>(i)));
+  });
+  add_case("3xGLint", [](opengl::program &prog, size_t i) {
+    auto const value = static_cast<GLint>(i);
+    return prog.set_uniform("cell", value, value, value);
+  });
+  add_case("3xGLfloat", [](opengl::program &prog, size_t i) {
+    auto const value = static_cast<GLfloat>(i);
+    return prog.set_uniform("offset", value, value, value);
+  });
+
+  // the same uploads through handles resolved once
+  benchmark::add("uniform_set/GLfloat", [] {
+    auto s = make_scene(0, 0);
+    auto scale = s->prog->get_uniform<GLfloat>("scale");
+    return benchmark::fixture{repeat([s, scale](size_t i) mutable {
+      return scale.set(static_cast<GLfloat>(i));
+    })};
+  });
+  benchmark::add("uniform_set/mat4", [] {
+    auto s = make_scene(0, 0);
+    auto model = s->prog->get_uniform<glm::mat4>("model");
+    return benchmark::fixture{repeat([s, model](size_t i) mutable {
+      return model.set(glm::mat4(static_cast<float>(i)));
+    })};
+  });
+}
+
+void add_program_use_cases() {
+  for (size_t textures : {0, 4, 16}) {
+    for (size_t blocks : {0, 4}) {
+      benchmark::add("program_use/textures:" + std::to_string(textures) +
+                         "/blocks:" + std::to_string(blocks),
+                     [textures, blocks] {
+                       auto s = make_scene(textures, blocks);
+                       return benchmark::fixture{
+                           repeat([s](size_t) { return s->prog->use(); })};
+                     });
+    }
+  }
+  for (size_t textures : {4, 16}) {
+    benchmark::add(
+        "program_use_texture_set/textures:" + std::to_string(textures),
+        [textures] {
+          auto s = make_scene(textures, 0);
+          auto set = std::make_shared<opengl::program::texture_set>();
+          for (size_t i = 0; i < textures; i++) {
+            if (!s->prog->add_to_texture_set(*set,
+                                             "texture" + std::to_string(i),
+                                             s->textures[i])) {
+              throw std::runtime_error("add_to_texture_set failed");
+            }
+          }
+          return benchmark::fixture{
+              repeat([s, set](size_t) { return s->prog->use(*set); })};
+        });
+  }
+}
+
+template <size_t size> void add_uniform_buffer_case() {
+  benchmark::add(
+      "uniform_buffer_write_flush/bytes:" + std::to_string(size), [] {
+        constexpr size_t buffer_size = 4096;
+        auto buffer = std::make_shared<opengl::uniform_buffer>(buffer_size);
+        std::array<float, size / sizeof(float)> data{};
+        return benchmark::fixture{
+            repeat([buffer, data](size_t i) mutable {
+              data[0] = static_cast<float>(i);
+              // a different range each time, 256 bytes apart like per-draw
+              // uniform data
+              auto const offset =
+                  static_cast<GLintptr>(i * 256 % buffer_size);
+              return buffer->write(data, offset) && buffer->flush();
+            }),
+            size};
+      });
+}
+
+// write_all and write_part are reached through array_buffer::write and
+// shader_storage_buffer::update
+void add_buffer_cases() {
+  for (size_t size : {size_t(256), size_t(64) << 10, size_t(4) << 20}) {
+    auto const data =
+        std::make_shared<std::vector<float>>(size / sizeof(float), 1.0f);
+    benchmark::add("buffer_write_all/bytes:" + std::to_string(size),
+                   [data, size] {
+                     auto buffer =
+                         std::make_shared<opengl::array_buffer<float>>();
+                     return benchmark::fixture{repeat([buffer, data](size_t) {
+                                                 return buffer->write(*data);
+                                               }),
+                                               size};
+                   });
+    benchmark::add(
+        "buffer_write_part/bytes:" + std::to_string(size), [data, size] {
+          auto buffer =
+              std::make_shared<opengl::shader_storage_buffer<float>>(
+                  data->size());
+          return benchmark::fixture{
+              repeat([buffer, data](size_t) {
+                return buffer->update(
+                    gsl::span<const float>(data->data(), data->size()), 0);
+              }),
+              size};
+        });
+  }
+}
+
+// the vertices and indices of a grid of quads x quads cells
+struct grid {
+  std::vector<opengl::mesh::vertex> vertices;
+  std::vector<GLuint> indices;
+};
+
+grid make_grid(size_t quads) {
+  grid g;
+  auto const side = quads + 1;
+  for (size_t z = 0; z < side; z++) {
+    for (size_t x = 0; x < side; x++) {
+      auto const u = static_cast<float>(x) / quads;
+      auto const v = static_cast<float>(z) / quads;
+      g.vertices.push_back({{u - 0.5f, 0.0f, v - 0.5f}, {0, 1, 0}, {u, v}});
+    }
+  }
+  for (size_t z = 0; z < quads; z++) {
+    for (size_t x = 0; x < quads; x++) {
+      auto const corner = static_cast<GLuint>(z * side + x);
+      auto const below = static_cast<GLuint>(corner + side);
+      g.indices.insert(g.indices.end(), {corner, below, corner + 1,
+                                         corner + 1, below, below + 1});
+    }
+  }
+  return g;
+}
+
+std::shared_ptr<opengl::mesh>
+make_grid_mesh(size_t quads,
+               std::map<opengl::texture_2D::type,
+                        std::vector<opengl::texture_2D>>
+                   textures) {
+  auto g = make_grid(quads);
+  return std::make_shared<opengl::mesh>(
+      std::move(g.vertices), std::move(g.indices), std::move(textures));
+}
+
+void add_draw_cases() {
+  for (size_t textures : {0, 1}) {
+    benchmark::add("mesh_draw/textures:" + std::to_string(textures),
+                   [textures] {
+                     auto s = make_scene(textures, 0);
+                     std::map<opengl::texture_2D::type,
+                              std::vector<opengl::texture_2D>>
+                         mesh_textures;
+                     texture_variable_names variable_names;
+                     if (textures != 0) {
+                       mesh_textures[opengl::texture_2D::type::diffuse] =
+                           s->textures;
+                       variable_names[opengl::texture_2D::type::diffuse] = {
+                           "texture0"};
+                     }
+                     auto m = make_grid_mesh(16, std::move(mesh_textures));
+                     return benchmark::fixture{
+                         repeat([s, m, variable_names](size_t) {
+                           return m->draw(*s->prog, variable_names);
+                         })};
+                   });
+  }
+
+  // trees of nodes sharing one small mesh; each draw visits every node
+  struct tree {
+    size_t branching;
+    size_t depth;
+  };
+  for (auto [branching, depth] :
+       {tree{4, 3}, tree{8, 3}, tree{2, 9}}) {
+    auto const name = "tree_" + std::to_string(branching) + "_" +
+                      std::to_string(depth);
+    benchmark::add(
+        "model_draw/branching:" + std::to_string(branching) +
+            "/depth:" + std::to_string(depth),
+        [name, branching = branching, depth = depth] {
+          auto const file = asset_directory / (name + ".gltf");
+          if (!benchmark::write_grid_model(file, 4, branching, depth)) {
+            throw std::runtime_error("write_grid_model failed");
+          }
+          auto s = make_scene(0, 0);
+          opengl::model::import_config config;
+          config.lod_count = 1;
+          auto m = std::make_shared<opengl::model>(file, config);
+          m->set_model_matrix_variable_name("model");
+          return benchmark::fixture{repeat([s, m](size_t) {
+            return m->draw(*s->prog, texture_variable_names{});
+          })};
+        });
+  }
+}
+
+// Many copies of one mesh spread over distance, drawn through the camera so
+// that far copies are drawn at coarser levels of detail or culled. The
+// counters are the triangle counts of the last draw.
+void add_lod_cases() {
+  for (size_t lod_count : {1, 4}) {
+    benchmark::add(
+        "model_draw_lod/meshes:64/lods:" + std::to_string(lod_count),
+        [lod_count] {
+          auto const file = asset_directory / "distance_64.gltf";
+          if (!benchmark::write_distance_model(file, 64, 64, 4.0f)) {
+            throw std::runtime_error("write_distance_model failed");
+          }
+          auto s = make_scene(0, 0);
+          opengl::model::import_config config;
+          config.lod_count = lod_count;
+          auto m = std::make_shared<opengl::model>(file, config);
+          m->set_model_matrix_variable_name("model");
+          auto view_camera = std::make_shared<opengl::camera>(
+              glm::vec3(0, 1, 1), glm::vec3(0, 1, 0), glm::vec3(0, 0, -1));
+          benchmark::fixture f{repeat([s, m, view_camera](size_t) {
+            return m->draw(*s->prog, texture_variable_names{}, *view_camera,
+                           1280, 720);
+          })};
+          f.counters = [m] {
+            auto const &statistics = m->get_lod_statistics();
+            return std::vector<std::pair<std::string, double>>{
+                {"drawn_triangles",
+                 static_cast<double>(statistics.drawn_triangles)},
+                {"full_detail_triangles",
+                 static_cast<double>(statistics.full_detail_triangles)},
+                {"culled_meshes",
+                 static_cast<double>(statistics.culled_meshes)}};
+          };
+          return f;
+        });
+  }
+}
+
+// N meshes drawn with a vertex array each, bound before each draw, against
+// one vertex array of the mesh vertex layout with each mesh's buffers
+// attached before its draw, as mesh does on OpenGL 4.5
+void add_vertex_array_cases() {
+  struct geometry {
+    opengl::array_buffer<float> VBO;
+    opengl::element_array_buffer<GLuint> EBO;
+    GLsizei index_count{};
+  };
+  struct vertex_array_scene {
+    std::shared_ptr<scene> s;
+    std::vector<geometry> meshes;
+    std::vector<opengl::vertex_array> per_mesh;
+    std::optional<opengl::vertex_array> shared;
+  };
+  constexpr GLuint binding = 0;
+  auto make_vertex_array_scene = [](size_t mesh_count) {
+    auto v = std::make_shared<vertex_array_scene>();
+    v->s = make_scene(0, 0);
+    auto const g = make_grid(4);
+    for (size_t i = 0; i < mesh_count; i++) {
+      auto &m = v->meshes.emplace_back();
+      m.index_count = static_cast<GLsizei>(g.indices.size());
+      if (!m.VBO.write(g.vertices) || !m.EBO.write(g.indices)) {
+        throw std::runtime_error("write mesh buffers failed");
+      }
+      auto &array = v->per_mesh.emplace_back(false);
+      if (!array.set_layout(opengl::mesh::vertex_format, binding) ||
+          !array.set_vertex_buffer(binding, m.VBO, 0,
+                                   sizeof(opengl::mesh::vertex)) ||
+          !array.set_element_buffer(m.EBO)) {
+        throw std::runtime_error("set up vertex array failed");
+      }
+    }
+    v->shared.emplace(false);
+    if (!v->shared->set_layout(opengl::mesh::vertex_format, binding)) {
+      throw std::runtime_error("set_layout failed");
+    }
+    return v;
+  };
+  auto draw = [](const geometry &m) {
+    glDrawElements(GL_TRIANGLES, m.index_count, GL_UNSIGNED_INT, nullptr);
+    return !opengl::check_error();
+  };
+
+  for (size_t mesh_count : {16, 256}) {
+    auto const suffix = "/meshes:" + std::to_string(mesh_count);
+    benchmark::add("vertex_array_per_mesh" + suffix,
+                   [make_vertex_array_scene, draw, mesh_count] {
+                     auto v = make_vertex_array_scene(mesh_count);
+                     return benchmark::fixture{repeat([v, draw](size_t) {
+                       if (!v->s->prog->use()) {
+                         return false;
+                       }
+                       for (size_t i = 0; i < v->meshes.size(); i++) {
+                         if (!v->per_mesh[i].use() || !draw(v->meshes[i])) {
+                           return false;
+                         }
+                       }
+                       return true;
+                     })};
+                   });
+    benchmark::add(
+        "vertex_array_shared_layout" + suffix,
+        [make_vertex_array_scene, draw, mesh_count] {
+          auto v = make_vertex_array_scene(mesh_count);
+          return benchmark::fixture{repeat([v, draw](size_t) {
+            if (!v->s->prog->use() || !v->shared->use()) {
+              return false;
+            }
+            for (auto const &m : v->meshes) {
+              if (!v->shared->set_vertex_buffer(
+                      binding, m.VBO, 0, sizeof(opengl::mesh::vertex)) ||
+                  !v->shared->set_element_buffer(m.EBO) || !draw(m)) {
+                return false;
+              }
+            }
+            return true;
+          })};
+        });
+  }
+}
+
+// convert_assimp_mesh is private to model; it is measured as part of loading
+// a model of one mesh, together with the import and the upload
+void add_model_load_cases() {
+  for (auto [quads, lod_count] :
+       std::initializer_list<std::pair<size_t, size_t>>{
+           {64, 1}, {256, 1}, {64, 4}}) {
+    benchmark::add(
+        "model_load/quads:" + std::to_string(quads) +
+            "/lods:" + std::to_string(lod_count),
+        [quads = quads, lod_count = lod_count] {
+          auto const file = asset_directory /
+                            ("grid_" + std::to_string(quads) + ".gltf");
+          if (!benchmark::write_grid_model(file, quads, 1, 0)) {
+            throw std::runtime_error("write_grid_model failed");
+          }
+          opengl::model::import_config config;
+          config.lod_count = lod_count;
+          return benchmark::fixture{repeat([file, config](size_t) {
+                                      opengl::model m(file, config);
+                                      return m.get_mesh_count() == 1;
+                                    }),
+                                    static_cast<size_t>(
+                                        std::filesystem::file_size(file))};
+        });
+  }
+}
+
+// load_texture_image is reached through the texture_2D constructor, which
+// also uploads the image and builds its mipmaps
+void add_texture_load_cases(const std::vector<std::filesystem::path> &images) {
+  auto add_case = [](const std::string &name,
+                     const std::function<std::filesystem::path()> &prepare) {
+    benchmark::add("texture_load/" + name, [prepare] {
+      auto const file = prepare();
+      return benchmark::fixture{repeat([file](size_t) {
+                                  opengl::texture_2D texture(file);
+                                  return true;
+                                }),
+                                static_cast<size_t>(
+                                    std::filesystem::file_size(file))};
+    });
+  };
+  for (size_t size : {256, 1024}) {
+    add_case("ppm:" + std::to_string(size), [size] {
+      auto const file =
+          asset_directory / ("image_" + std::to_string(size) + ".ppm");
+      if (!benchmark::write_ppm_image(file, size, size)) {
+        throw std::runtime_error("write_ppm_image failed");
+      }
+      return file;
+    });
+  }
+  for (auto const &image : images) {
+    add_case(image.filename().string(), [image] { return image; });
+  }
+}
+
+void print_usage(const char *program_name) {
+  std::cerr
+      << "usage:" << program_name
+      << " [--context] [--filter text] [--min-time seconds] [--json file]"
+         " [--image file]... [--list]\n"
+         "  --context  run on a hidden window's context instead of the null"
+         " backend;\n"
+         "             set LIBGL_ALWAYS_SOFTWARE=1 for a software renderer\n"
+         "  --image    also measure loading this image"
+      << std::endl;
+}
+} // namespace
+
+// Measures the wrapper hot paths. By default GL is the null backend, so the
+// numbers are the CPU cost of the library alone.
+int main(int argc, char **argv) {
+  benchmark::run_options options;
+  std::optional<std::filesystem::path> json_file;
+  std::vector<std::filesystem::path> images;
+  bool use_context = false;
+  bool list = false;
+  for (int i = 1; i < argc; i++) {
+    std::string_view const argument = argv[i];
+    auto const has_value = i + 1 < argc;
+    if (argument == "--context") {
+      use_context = true;
+    } else if (argument == "--list") {
+      list = true;
+    } else if (argument == "--filter" && has_value) {
+      options.filter = argv[++i];
+    } else if (argument == "--min-time" && has_value) {
+      options.min_seconds = std::atof(argv[++i]);
+    } else if (argument == "--json" && has_value) {
+      json_file = argv[++i];
+    } else if (argument == "--image" && has_value) {
+      images.emplace_back(argv[++i]);
+    } else {
+      print_usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  add_set_uniform_cases();
+  add_program_use_cases();
+  add_uniform_buffer_case<16>();
+  add_uniform_buffer_case<64>();
+  add_uniform_buffer_case<256>();
+  add_buffer_cases();
+  add_draw_cases();
+  add_lod_cases();
+  add_vertex_array_cases();
+  add_model_load_cases();
+  add_texture_load_cases(images);
+  if (list) {
+    for (auto const &name : benchmark::get_names()) {
+      std::cout << name << std::endl;
+    }
+    return EXIT_SUCCESS;
+  }
+
+  std::optional<opengl::context::window> window;
+  if (use_context) {
+    // context::create keeps the hints set after the first glfwInit
+    if (glfwInit() != GLFW_TRUE) {
+      std::cerr << "glfwInit failed" << std::endl;
+      return EXIT_FAILURE;
+    }
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    window = opengl::context::create(64, 64, "benchmarks");
+    if (!window) {
+      return EXIT_FAILURE;
+    }
+    options.synchronize = [] { glFinish(); };
+  } else {
+    opengl::null_backend::install();
+  }
+
+  std::error_code error;
+  asset_directory =
+      std::filesystem::temp_directory_path(error) / "opengl_cpp_benchmarks";
+  std::filesystem::create_directories(asset_directory, error);
+  if (error) {
+    std::cerr << "create " << asset_directory << " failed:" << error.message()
+              << std::endl;
+    return EXIT_FAILURE;
+  }
+  auto const remove_assets = gsl::finally([] {
+    std::error_code ignored;
+    std::filesystem::remove_all(asset_directory, ignored);
+  });
+
+  std::vector<benchmark::result> results;
+  auto succeeded = benchmark::run(options, results);
+  if (json_file &&
+      !benchmark::write_json(*json_file, results,
+                             use_context ? "context" : "null")) {
+    succeeded = false;
+  }
+  return succeeded ? EXIT_SUCCESS : EXIT_FAILURE;
+}
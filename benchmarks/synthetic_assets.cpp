@@ -0,0 +1,259 @@
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <utility>
+
+#include "synthetic_assets.hpp"
+
+namespace benchmark {
+
+namespace {
+std::string to_base64(const std::vector<uint8_t> &bytes) {
+  static constexpr char digits[] =
+      "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  std::string text;
+  text.reserve((bytes.size() + 2) / 3 * 4);
+  for (size_t i = 0; i < bytes.size(); i += 3) {
+    uint32_t group = static_cast<uint32_t>(bytes[i]) << 16;
+    if (i + 1 < bytes.size()) {
+      group |= static_cast<uint32_t>(bytes[i + 1]) << 8;
+    }
+    if (i + 2 < bytes.size()) {
+      group |= bytes[i + 2];
+    }
+    text.push_back(digits[(group >> 18) & 63]);
+    text.push_back(digits[(group >> 12) & 63]);
+    text.push_back(i + 1 < bytes.size() ? digits[(group >> 6) & 63] : '=');
+    text.push_back(i + 2 < bytes.size() ? digits[group & 63] : '=');
+  }
+  return text;
+}
+
+template <typename T> void append(std::vector<uint8_t> &bytes, T value) {
+  auto const size = bytes.size();
+  bytes.resize(size + sizeof(T));
+  std::memcpy(bytes.data() + size, &value, sizeof(T));
+}
+
+bool write_file(const std::filesystem::path &file, const std::string &data) {
+  std::ofstream out(file, std::ios::binary | std::ios::trunc);
+  out.write(data.data(), static_cast<std::streamsize>(data.size()));
+  if (!out) {
+    std::cerr << "write " << file << " failed" << std::endl;
+    return false;
+  }
+  return true;
+}
+} // namespace
+
+shader_sources make_shader_sources(size_t textures, size_t blocks) {
+  shader_sources sources;
+  sources.vertex = R"(#version 450 core
+layout(location = 0) in vec3 position;
+layout(location = 1) in vec3 normal;
+layout(location = 2) in vec2 texture_coord;
+uniform mat4 model;
+uniform mat4 view_projection;
+uniform float scale;
+uniform ivec3 cell;
+out vec2 uv;
+out vec3 world_normal;
+void main() {
+  uv = texture_coord;
+  world_normal = mat3(model) * normal;
+  gl_Position =
+      view_projection * model * vec4(position * scale + vec3(cell), 1.0);
+}
+)";
+
+  std::string declarations;
+  std::string statements;
+  for (size_t i = 0; i < textures; i++) {
+    auto const name = "texture" + std::to_string(i);
+    declarations += "uniform sampler2D " + name + ";\n";
+    statements += "  color += texture(" + name + ", uv);\n";
+  }
+  for (size_t i = 0; i < blocks; i++) {
+    auto const suffix = std::to_string(i);
+    declarations += "layout(std140) uniform block" + suffix + " {\n" +
+                    "  vec4 color" + suffix + ";\n" + "  mat4 transform" +
+                    suffix + ";\n};\n";
+    statements += "  color += transform" + suffix + " * color" + suffix + ";\n";
+  }
+  sources.fragment = R"(#version 450 core
+in vec2 uv;
+in vec3 world_normal;
+out vec4 frag_color;
+uniform vec3 tint;
+uniform vec3 offset;
+uniform int mode;
+)" + declarations + R"(void main() {
+  vec4 color = vec4(tint + offset + world_normal, float(mode));
+)" + statements + R"(  frag_color = color;
+}
+)";
+  return sources;
+}
+
+std::vector<opengl::null_backend::uniform_variable>
+make_program_interface(size_t textures, size_t blocks) {
+  using uniform_variable = opengl::null_backend::uniform_variable;
+  auto plain = [](std::string name, GLenum type) {
+    uniform_variable uniform;
+    uniform.name = std::move(name);
+    uniform.type = type;
+    return uniform;
+  };
+  std::vector<uniform_variable> uniforms{
+      plain("model", GL_FLOAT_MAT4), plain("view_projection", GL_FLOAT_MAT4),
+      plain("scale", GL_FLOAT),      plain("cell", GL_INT_VEC3),
+      plain("tint", GL_FLOAT_VEC3),  plain("offset", GL_FLOAT_VEC3),
+      plain("mode", GL_INT),
+  };
+  for (size_t i = 0; i < textures; i++) {
+    uniforms.push_back(plain("texture" + std::to_string(i), GL_SAMPLER_2D));
+  }
+  for (size_t i = 0; i < blocks; i++) {
+    auto const suffix = std::to_string(i);
+    auto const block = "block" + suffix;
+    uniforms.push_back({"color" + suffix, GL_FLOAT_VEC4, 1, block, 0, 0});
+    uniforms.push_back(
+        {"transform" + suffix, GL_FLOAT_MAT4, 1, block, 16, 0});
+  }
+  return uniforms;
+}
+
+namespace {
+// a glTF 2.0 document with one grid mesh of quads x quads cells in an
+// embedded buffer, the given nodes and a scene of the given root nodes
+std::string make_grid_gltf(size_t quads, const std::string &nodes,
+                           const std::string &scene_nodes) {
+  auto const side = quads + 1;
+  auto const vertex_count = side * side;
+  auto const index_count = quads * quads * 6;
+
+  std::vector<uint8_t> bytes;
+  for (size_t z = 0; z < side; z++) {
+    for (size_t x = 0; x < side; x++) {
+      append(bytes, static_cast<float>(x) / quads - 0.5f);
+      append(bytes, 0.0f);
+      append(bytes, static_cast<float>(z) / quads - 0.5f);
+    }
+  }
+  auto const normal_offset = bytes.size();
+  for (size_t i = 0; i < vertex_count; i++) {
+    append(bytes, 0.0f);
+    append(bytes, 1.0f);
+    append(bytes, 0.0f);
+  }
+  auto const uv_offset = bytes.size();
+  for (size_t z = 0; z < side; z++) {
+    for (size_t x = 0; x < side; x++) {
+      append(bytes, static_cast<float>(x) / quads);
+      append(bytes, static_cast<float>(z) / quads);
+    }
+  }
+  auto const index_offset = bytes.size();
+  for (size_t z = 0; z < quads; z++) {
+    for (size_t x = 0; x < quads; x++) {
+      auto const corner = static_cast<uint32_t>(z * side + x);
+      auto const below = static_cast<uint32_t>(corner + side);
+      for (auto index :
+           {corner, below, corner + 1, corner + 1, below, below + 1}) {
+        append(bytes, index);
+      }
+    }
+  }
+
+  std::ostringstream json;
+  json << "{\"asset\":{\"version\":\"2.0\"},\"scene\":0,"
+       << "\"scenes\":[{\"nodes\":[" << scene_nodes << "]}],\"nodes\":["
+       << nodes << "],"
+       << "\"meshes\":[{\"primitives\":[{\"attributes\":{\"POSITION\":0,"
+       << "\"NORMAL\":1,\"TEXCOORD_0\":2},\"indices\":3}]}],"
+       << "\"buffers\":[{\"byteLength\":" << bytes.size()
+       << ",\"uri\":\"data:application/octet-stream;base64,"
+       << to_base64(bytes) << "\"}],"
+       << "\"bufferViews\":["
+       << "{\"buffer\":0,\"byteOffset\":0,\"byteLength\":" << normal_offset
+       << ",\"target\":34962},"
+       << "{\"buffer\":0,\"byteOffset\":" << normal_offset
+       << ",\"byteLength\":" << uv_offset - normal_offset
+       << ",\"target\":34962},"
+       << "{\"buffer\":0,\"byteOffset\":" << uv_offset
+       << ",\"byteLength\":" << index_offset - uv_offset
+       << ",\"target\":34962},"
+       << "{\"buffer\":0,\"byteOffset\":" << index_offset
+       << ",\"byteLength\":" << bytes.size() - index_offset
+       << ",\"target\":34963}],"
+       << "\"accessors\":["
+       << "{\"bufferView\":0,\"componentType\":5126,\"count\":" << vertex_count
+       << ",\"type\":\"VEC3\",\"min\":[-0.5,0,-0.5],\"max\":[0.5,0,0.5]},"
+       << "{\"bufferView\":1,\"componentType\":5126,\"count\":" << vertex_count
+       << ",\"type\":\"VEC3\"},"
+       << "{\"bufferView\":2,\"componentType\":5126,\"count\":" << vertex_count
+       << ",\"type\":\"VEC2\"},"
+       << "{\"bufferView\":3,\"componentType\":5125,\"count\":" << index_count
+       << ",\"type\":\"SCALAR\"}]}";
+  return json.str();
+}
+} // namespace
+
+bool write_grid_model(const std::filesystem::path &file, size_t quads,
+                      size_t branching, size_t depth) {
+  // the nodes in breadth-first order; node i has the children
+  // i * branching + 1 to i * branching + branching
+  size_t node_count = 0;
+  for (size_t level = 0, width = 1; level <= depth;
+       level++, width *= branching) {
+    node_count += width;
+  }
+  std::ostringstream nodes;
+  for (size_t i = 0; i < node_count; i++) {
+    nodes << (i == 0 ? "" : ",") << "{\"mesh\":0,\"translation\":["
+          << (i == 0 ? 0 : (i - 1) % branching) << ",0,1]";
+    auto const first_child = i * branching + 1;
+    if (first_child < node_count) {
+      nodes << ",\"children\":[";
+      for (size_t child = 0; child < branching; child++) {
+        nodes << (child == 0 ? "" : ",") << first_child + child;
+      }
+      nodes << "]";
+    }
+    nodes << "}";
+  }
+  return write_file(file, make_grid_gltf(quads, nodes.str(), "0"));
+}
+
+bool write_distance_model(const std::filesystem::path &file, size_t quads,
+                          size_t count, float spacing) {
+  std::ostringstream nodes;
+  std::ostringstream scene_nodes;
+  for (size_t i = 0; i < count; i++) {
+    nodes << (i == 0 ? "" : ",") << "{\"mesh\":0,\"translation\":[0,0,"
+          << -spacing * static_cast<float>(i + 1) << "]}";
+    scene_nodes << (i == 0 ? "" : ",") << i;
+  }
+  return write_file(file,
+                    make_grid_gltf(quads, nodes.str(), scene_nodes.str()));
+}
+
+bool write_ppm_image(const std::filesystem::path &file, size_t width,
+                     size_t height) {
+  std::string data = "P6\n" + std::to_string(width) + " " +
+                     std::to_string(height) + "\n255\n";
+  data.reserve(data.size() + width * height * 3);
+  for (size_t y = 0; y < height; y++) {
+    for (size_t x = 0; x < width; x++) {
+      data.push_back(static_cast<char>(x * 255 / width));
+      data.push_back(static_cast<char>(y * 255 / height));
+      data.push_back(static_cast<char>((x ^ y) & 255));
+    }
+  }
+  return write_file(file, data);
+}
+
+} // namespace benchmark
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "null_backend.hpp"
+
+namespace benchmark {
+
+// A vertex and a fragment shader using every uniform they declare, so that
+// a real driver keeps all of them active:
+//   float scale, int mode, vec3 tint, vec3 offset, ivec3 cell, mat4 model,
+//   mat4 view_projection, sampler2D texture0..texture<textures - 1>, and the
+//   std140 blocks block0..block<blocks - 1> with the members vec4 color<i>
+//   and mat4 transform<i>.
+struct shader_sources {
+  std::string vertex;
+  std::string fragment;
+};
+shader_sources make_shader_sources(size_t textures, size_t blocks);
+
+// the interface a driver reflects from make_shader_sources(textures, blocks)
+std::vector<opengl::null_backend::uniform_variable>
+make_program_interface(size_t textures, size_t blocks);
+
+// A glTF 2.0 file with one grid mesh of quads x quads cells in an embedded
+// buffer, and a tree of nodes with the given branching and depth that all
+// reference the mesh. depth 0 is the root alone.
+bool write_grid_model(const std::filesystem::path &file, size_t quads,
+                      size_t branching, size_t depth);
+
+// The same grid mesh referenced by count root nodes along -z, at spacing,
+// 2 * spacing and so on from the origin, for levels of detail by distance.
+bool write_distance_model(const std::filesystem::path &file, size_t quads,
+                          size_t count, float spacing);
+
+// a binary PPM image with a color gradient
+bool write_ppm_image(const std::filesystem::path &file, size_t width,
+                     size_t height);
+
+} // namespace benchmark
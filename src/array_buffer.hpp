@@ -1,6 +1,7 @@
 #pragma once
 
 #include "buffer.hpp"
+#include "vertex_layout.hpp"
 
 namespace opengl {
 
@@ -35,14 +36,35 @@ public:
   }
 
   bool vertex_attribute_pointer(GLuint index, GLint size, GLsizei stride,
-                                size_t offset) noexcept {
+                                size_t offset, GLuint divisor = 0) noexcept {
+    return vertex_attribute_pointer(
+        {index, size, GL_FLOAT, GL_FALSE, static_cast<GLuint>(offset)},
+        stride, divisor);
+  }
+
+  // classic counterpart of vertex_array::set_layout for the bound vertex
+  // array
+  template <size_t N>
+  bool vertex_attribute_pointers(const opengl::vertex_layout<N> &layout,
+                                 GLuint divisor = 0) noexcept {
+    for (auto const &attribute : layout.attributes) {
+      if (!vertex_attribute_pointer(attribute, layout.stride, divisor)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool vertex_attribute_pointer(const opengl::vertex_attribute &attribute,
+                                GLsizei stride, GLuint divisor = 0) noexcept {
     if (!bind()) {
       return false;
     }
 
-    GLenum type = GL_FLOAT;
-    glVertexAttribPointer(index, size, type, GL_FALSE, stride,
-                          reinterpret_cast<void *>(offset));
+    auto const index = attribute.index;
+    glVertexAttribPointer(
+        index, attribute.size, attribute.type, attribute.normalized, stride,
+        reinterpret_cast<void *>(static_cast<size_t>(attribute.offset)));
     if (check_error()) {
       std::cerr << "glVertexAttribPointer failed" << std::endl;
       return false;
@@ -53,6 +75,14 @@ public:
       std::cerr << "glEnableVertexAttribArray failed" << std::endl;
       return false;
     }
+
+    if (divisor != 0) {
+      glVertexAttribDivisor(index, divisor);
+      if (check_error()) {
+        std::cerr << "glVertexAttribDivisor failed" << std::endl;
+        return false;
+      }
+    }
     return true;
   }
 };
@@ -5,6 +5,7 @@
 
 #include "context.hpp"
 #include "error.hpp"
+#include "render_statistics.hpp"
 
 namespace opengl {
 
@@ -22,6 +23,7 @@ public:
         throw_exception("glCreateBuffers failed");
       }
     }
+    render_statistics::get_current().objects_created++;
   }
 
   buffer(const buffer &) = delete;
@@ -32,8 +34,12 @@ public:
 
   virtual ~buffer() noexcept = default;
 
+  size_t get_size() const noexcept { return allocated_size; }
+
 protected:
-  bool alloc(size_t size) noexcept {
+  // usage is the hint for the driver, e.g. GL_STREAM_DRAW for storage that is
+  // respecified every frame
+  bool alloc(size_t size, GLenum usage = GL_STATIC_DRAW) noexcept {
     if (size == 0) {
       std::cerr << "can't alloc 0 bytes" << std::endl;
       return false;
@@ -45,14 +51,15 @@ protected:
       }
     }
     if constexpr (opengl::context::gl_minor_version < 5) {
-      glBufferData(target, size, nullptr, GL_STATIC_DRAW);
+      glBufferData(target, size, nullptr, usage);
     } else {
-      glNamedBufferData(*buffer_id, size, nullptr, GL_STATIC_DRAW);
+      glNamedBufferData(*buffer_id, size, nullptr, usage);
     }
     if (check_error()) {
       std::cerr << "glBufferData failed" << std::endl;
       return false;
     }
+    allocated_size = size;
     return true;
   }
 
@@ -78,10 +85,14 @@ protected:
       std::cerr << "glBufferSubData failed" << std::endl;
       return false;
     }
+    render_statistics::get_current().buffer_uploaded_bytes +=
+        data_view.size_bytes();
     return true;
   }
 
-  template <typename T> bool write_all(gsl::span<const T> data_view) noexcept {
+  template <typename T>
+  bool write_all(gsl::span<const T> data_view,
+                 GLenum usage = GL_STATIC_DRAW) noexcept {
     if (data_view.empty()) {
       std::cerr << "can't write empty data" << std::endl;
       return false;
@@ -93,16 +104,17 @@ protected:
       }
     }
     if constexpr (opengl::context::gl_minor_version < 5) {
-      glBufferData(target, data_view.size_bytes(), data_view.data(),
-                   GL_STATIC_DRAW);
+      glBufferData(target, data_view.size_bytes(), data_view.data(), usage);
     } else {
       glNamedBufferData(*buffer_id, data_view.size_bytes(), data_view.data(),
-                        GL_STATIC_DRAW);
+                        usage);
     }
     if (check_error()) {
       std::cerr << "glBufferData failed" << std::endl;
       return false;
     }
+    allocated_size = data_view.size_bytes();
+    render_statistics::get_current().buffer_uploaded_bytes += allocated_size;
     return true;
   }
 
@@ -116,12 +128,18 @@ protected:
   }
 
 protected:
+  friend class program;
+  friend class vertex_array;
   std::unique_ptr<GLuint, std::function<void(GLuint *)>> buffer_id{
       new GLuint(0), [](auto ptr) {
+        if (*ptr != 0) {
+          render_statistics::get_current().objects_deleted++;
+        }
         glDeleteBuffers(1, ptr);
         delete ptr;
       }};
   GLenum target;
+  size_t allocated_size{};
 };
 
 } // namespace opengl
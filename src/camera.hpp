@@ -95,7 +95,7 @@ public:
       fov = 45.0f;
   }
 
-  float get_fov() { return glm::radians(fov); }
+  float get_fov() const { return glm::radians(fov); }
 
   const auto &get_position() const { return position; }
 
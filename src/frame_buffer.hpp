@@ -25,6 +25,7 @@ public:
         throw_exception("glCreateFramebuffers failed");
       }
     }
+    render_statistics::get_current().objects_created++;
   }
 
   frame_buffer(const frame_buffer &) = delete;
@@ -138,6 +139,9 @@ private:
 
   std::unique_ptr<GLuint, std::function<void(GLuint *)>> frame_buffer_id{
       new GLuint(0), [](auto ptr) {
+        if (*ptr != 0) {
+          render_statistics::get_current().objects_deleted++;
+        }
         glDeleteFramebuffers(1, ptr);
         delete ptr;
       }};
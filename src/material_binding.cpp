@@ -0,0 +1,86 @@
+
+#include <iostream>
+
+#include "material_binding.hpp"
+#include "mesh.hpp"
+#include "model.hpp"
+
+namespace opengl {
+
+material_binding::material_binding(
+    opengl::program &prog, const opengl::mesh &m,
+    const std::map<texture_2D::type, std::vector<std::string>>
+        &texture_variable_names) {
+  materials.push_back(bind(prog, m, texture_variable_names));
+}
+
+material_binding::material_binding(
+    opengl::program &prog, const opengl::model &m,
+    const std::map<texture_2D::type, std::vector<std::string>>
+        &texture_variable_names) {
+  materials.reserve(m.get_mesh_count());
+  for (size_t i = 0; i < m.get_mesh_count(); i++) {
+    materials.push_back(bind(prog, m.get_mesh(i), texture_variable_names));
+  }
+}
+
+material_binding::material material_binding::bind(
+    opengl::program &prog, const opengl::mesh &m,
+    const std::map<texture_2D::type, std::vector<std::string>>
+        &texture_variable_names) {
+  material result;
+  for (auto const &[type, variable_names] : texture_variable_names) {
+    auto layer_it = m.texture_layers.find(type);
+    if (layer_it != m.texture_layers.end()) {
+      auto const &layers = layer_it->second;
+      if (variable_names.size() > layers.size()) {
+        throw_exception("more variable then texture:" +
+                        std::to_string(variable_names.size()) + ' ' +
+                        std::to_string(layers.size()));
+      }
+      for (size_t i = 0; i < variable_names.size(); i++) {
+        if (!prog.add_to_texture_set(result.textures, variable_names[i],
+                                     layers[i].array)) {
+          throw_exception("add_to_texture_set failed:" + variable_names[i]);
+        }
+        auto const layer_name = variable_names[i] + "_layer";
+        auto uniform_it = layer_uniforms.find(layer_name);
+        if (uniform_it == layer_uniforms.end()) {
+          auto layer_uniform = prog.get_uniform<GLint>(layer_name);
+          if (!layer_uniform.is_valid()) {
+            throw_exception("no layer uniform:" + layer_name);
+          }
+          uniform_it =
+              layer_uniforms.emplace(layer_name, std::move(layer_uniform))
+                  .first;
+        }
+        result.layers.emplace_back(&uniform_it->second, layers[i].layer);
+      }
+      continue;
+    }
+
+    auto it = m.textures.find(type);
+    if (it == m.textures.end()) {
+      throw_exception("no texture for type " +
+                      std::to_string(static_cast<int>(type)));
+    }
+    if (variable_names.size() > it->second.size()) {
+      throw_exception("more variable then texture:" +
+                      std::to_string(variable_names.size()) + ' ' +
+                      std::to_string(it->second.size()));
+    }
+    if (variable_names.size() < it->second.size()) {
+      std::cerr << "less variable then texture:" << variable_names.size() << ' '
+                << it->second.size() << std::endl;
+    }
+    for (size_t i = 0; i < variable_names.size(); i++) {
+      if (!prog.add_to_texture_set(result.textures, variable_names[i],
+                                   it->second[i])) {
+        throw_exception("add_to_texture_set failed:" + variable_names[i]);
+      }
+    }
+  }
+  return result;
+}
+
+} // namespace opengl
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "program.hpp"
+#include "texture.hpp"
+#include "uniform.hpp"
+
+namespace opengl {
+
+class mesh;
+class model;
+
+// The texture variables of a program resolved once for every mesh of a model
+// (or a single mesh): texture units, samplers, texture names and texture
+// array layers. Drawing with a binding instead of the texture variable name
+// map binds the prepared units directly, without lookups or strings.
+//
+// A binding refers to the textures of the meshes it was built from and to the
+// program's uniform locations, so rebuild it after relinking the program or
+// changing set_sampler. Layer uniforms are uploaded only when they change;
+// setting them by name in between leaves the binding unaware of it.
+class material_binding final {
+
+public:
+  // the prepared textures of one mesh
+  struct material {
+    opengl::program::texture_set textures;
+    // the "<variable>_layer" uniforms of texture array layers, shared by all
+    // materials of the binding, and the layer of this mesh
+    std::vector<std::pair<opengl::uniform<GLint> *, GLint>> layers;
+  };
+
+public:
+  material_binding(opengl::program &prog, const opengl::mesh &m,
+                   const std::map<texture_2D::type, std::vector<std::string>>
+                       &texture_variable_names);
+
+  // one material per mesh of m, in mesh index order
+  material_binding(opengl::program &prog, const opengl::model &m,
+                   const std::map<texture_2D::type, std::vector<std::string>>
+                       &texture_variable_names);
+
+  material_binding(const material_binding &) = delete;
+  material_binding &operator=(const material_binding &) = delete;
+
+  // the layer uniforms are map nodes, which moving keeps in place
+  material_binding(material_binding &&) noexcept = default;
+  material_binding &operator=(material_binding &&) noexcept = default;
+
+  ~material_binding() noexcept = default;
+
+  size_t get_material_count() const noexcept { return materials.size(); }
+  const material &get_material(size_t mesh_index) const {
+    return materials.at(mesh_index);
+  }
+
+private:
+  material bind(opengl::program &prog, const opengl::mesh &m,
+                const std::map<texture_2D::type, std::vector<std::string>>
+                    &texture_variable_names);
+
+private:
+  std::vector<material> materials;
+  std::map<std::string, opengl::uniform<GLint>, std::less<>> layer_uniforms;
+};
+
+} // namespace opengl
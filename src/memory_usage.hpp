@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstddef>
+
+namespace opengl {
+
+// bytes held in system memory and, as far as known to us, in video memory
+struct memory_usage {
+  size_t cpu_bytes{};
+  size_t gpu_bytes{};
+
+  memory_usage &operator+=(const memory_usage &rhs) noexcept {
+    cpu_bytes += rhs.cpu_bytes;
+    gpu_bytes += rhs.gpu_bytes;
+    return *this;
+  }
+};
+
+} // namespace opengl
@@ -1,56 +1,315 @@
 
+#include <algorithm>
 #include <iostream>
+#include <limits>
+#include <map>
 
 #include "mesh.hpp"
+#include "texture_streamer.hpp"
 
 namespace opengl {
 
+namespace {
+constexpr GLuint vertex_binding = 0;
+constexpr GLuint instance_binding = 1;
+} // namespace
+
 mesh::mesh(
     std::vector<vertex> vertices_, std::vector<GLuint> indices_,
-    std::map<texture_2D::type, std::vector<opengl::texture_2D>> textures_)
+    std::map<texture_2D::type, std::vector<opengl::texture_2D>> textures_,
+    std::vector<std::vector<GLuint>> lod_indices_,
+    geometry_retention retention)
     : vertices(std::move(vertices_)), indices(std::move(indices_)),
       textures(std::move(textures_)) {
 
-  if (!VAO.use()) {
-    throw_exception("use VAO failed");
+  for (auto const &[_, typed_textures] : textures) {
+    for (auto const &texture : typed_textures) {
+      has_streamed_textures = has_streamed_textures || texture.is_streamed();
+    }
   }
-  if (!EBO.write(indices)) {
-    throw_exception("EBO write failed");
+
+  lod_levels.push_back({0, indices.size()});
+  for (auto const &lod_indices : lod_indices_) {
+    lod_levels.push_back({indices.size(), lod_indices.size()});
+    indices.insert(indices.end(), lod_indices.begin(), lod_indices.end());
   }
 
-  if (!EBO.use()) {
-    throw_exception("use EBO failed");
+  if (!vertices.empty()) {
+    glm::vec3 min_corner = vertices[0].position;
+    glm::vec3 max_corner = vertices[0].position;
+    for (auto const &v : vertices) {
+      min_corner = glm::min(min_corner, v.position);
+      max_corner = glm::max(max_corner, v.position);
+    }
+    bounds.center = (min_corner + max_corner) * 0.5f;
+    for (auto const &v : vertices) {
+      bounds.radius =
+          std::max(bounds.radius, glm::distance(bounds.center, v.position));
+    }
   }
 
+  if constexpr (opengl::context::gl_minor_version < 5) {
+    // bound first, since writing the EBO binds it to the current VAO
+    VAO = std::make_shared<opengl::vertex_array>(true);
+  }
+  if (!EBO.write(indices)) {
+    throw_exception("EBO write failed");
+  }
   if (!VBO.write(vertices)) {
     throw_exception("VBO write failed");
   }
 
-  if (!VBO.vertex_attribute_pointer(0, 3, sizeof(vertex),
-                                    offsetof(vertex, position))) {
-    throw_exception("VBO vertex_attribute_pointer failed");
+  if constexpr (opengl::context::gl_minor_version < 5) {
+    if (!EBO.use()) {
+      throw_exception("use EBO failed");
+    }
+    if (!VBO.vertex_attribute_pointers(vertex_format)) {
+      throw_exception("VBO vertex_attribute_pointers failed");
+    }
+    if (!VAO->unuse()) {
+      throw_exception("unuse VAO failed");
+    }
+  } else {
+    VAO = get_layout_vertex_array(no_instance_attribute);
+  }
+
+  if (retention == geometry_retention::release) {
+    release_cpu_geometry();
+  }
+}
+
+gsl::span<const GLuint> mesh::get_indices(size_t lod) const {
+  if (!cpu_geometry_retained) {
+    return {};
+  }
+  auto const &level = lod_levels.at(lod);
+  return gsl::span<const GLuint>(indices.data() + level.first_index,
+                                 level.index_count);
+}
+
+void mesh::report_texture_footprint(float screen_pixels) const {
+  if (!has_streamed_textures) {
+    return;
+  }
+  for (auto const &[_, typed_textures] : textures) {
+    for (auto const &texture : typed_textures) {
+      opengl::texture_streamer::instance().report_footprint(texture,
+                                                            screen_pixels);
+    }
+  }
+}
+
+void mesh::set_texture_layers(
+    std::map<texture_2D::type, std::vector<texture_layer>> layers) {
+  texture_layers = std::move(layers);
+}
+
+void mesh::release_cpu_geometry() noexcept {
+  std::vector<vertex>().swap(vertices);
+  std::vector<GLuint>().swap(indices);
+  cpu_geometry_retained = false;
+}
+
+opengl::memory_usage mesh::get_memory_usage(bool include_textures) const
+    noexcept {
+  opengl::memory_usage usage;
+  usage.cpu_bytes = vertices.capacity() * sizeof(vertex) +
+                    indices.capacity() * sizeof(GLuint) +
+                    lod_levels.capacity() * sizeof(lod_level);
+  usage.gpu_bytes = VBO.get_size() + EBO.get_size();
+  if (include_textures) {
+    for (auto const &[_, typed_textures] : textures) {
+      for (auto const &texture : typed_textures) {
+        usage.gpu_bytes += texture.get_memory_size();
+      }
+    }
+    for (auto const &[_, layers] : texture_layers) {
+      for (auto const &layer : layers) {
+        usage.gpu_bytes += layer.array.get_memory_size();
+      }
+    }
   }
-  if (!VBO.vertex_attribute_pointer(1, 3, sizeof(vertex),
-                                    offsetof(vertex, normal))) {
-    throw_exception("VBO vertex_attribute_pointer failed");
+  return usage;
+}
+
+std::shared_ptr<opengl::vertex_array>
+mesh::get_layout_vertex_array(GLuint instance_location) {
+  static std::map<uint64_t, std::weak_ptr<opengl::vertex_array>> layouts;
+  auto const hash =
+      instance_location == no_instance_attribute
+          ? vertex_format.hash()
+          : combine_layout_hashes(vertex_format.hash(),
+                                  mat4_layout(instance_location).hash());
+  auto &cached = layouts[hash];
+  if (auto VAO = cached.lock()) {
+    return VAO;
   }
 
-  if (!VBO.vertex_attribute_pointer(2, 2, sizeof(vertex),
-                                    offsetof(vertex, texture_coord))) {
-    throw_exception("VBO vertex_attribute_pointer failed");
+  auto VAO = std::make_shared<opengl::vertex_array>(false);
+  if (!VAO->set_layout(vertex_format, vertex_binding)) {
+    throw_exception("set_layout failed");
+  }
+  if (instance_location != no_instance_attribute &&
+      !VAO->set_layout(mat4_layout(instance_location), instance_binding, 1)) {
+    throw_exception("set_layout failed");
   }
+  cached = VAO;
+  return VAO;
+}
 
-  if (!VAO.unuse()) {
-    throw_exception("unuse VAO failed");
+bool mesh::set_instance_buffer(opengl::array_buffer<float> &instance_buffer,
+                               GLuint first_location) {
+  layout_hash = combine_layout_hashes(vertex_format.hash(),
+                                      mat4_layout(first_location).hash());
+  if constexpr (opengl::context::gl_minor_version >= 5) {
+    VAO = get_layout_vertex_array(first_location);
+    instance_VBO = &instance_buffer;
+    return true;
+  }
+  if (!VAO->use()) {
+    return false;
+  }
+  if (!instance_buffer.vertex_attribute_pointers(mat4_layout(first_location),
+                                                 1)) {
+    return false;
   }
+  return VAO->unuse();
 }
 
 bool mesh::draw(opengl::program &prog,
                 const std::map<texture_2D::type, std::vector<std::string>>
-                    &texture_variable_names) {
-  prog.set_vertex_array(VAO);
+                    &texture_variable_names,
+                size_t lod) {
+  return prepare_draw(prog, texture_variable_names, lod) && draw_elements(lod);
+}
+
+bool mesh::draw(opengl::program &prog,
+                const opengl::material_binding::material &material,
+                size_t lod) {
+  return prepare_draw(prog, material, lod) && draw_elements(lod);
+}
+
+bool mesh::draw_instanced(
+    opengl::program &prog,
+    const std::map<texture_2D::type, std::vector<std::string>>
+        &texture_variable_names,
+    GLsizei instance_count, GLuint base_instance, size_t lod) {
+  return prepare_draw(prog, texture_variable_names, lod) &&
+         draw_elements_instanced(instance_count, base_instance, lod);
+}
+
+bool mesh::draw_instanced(opengl::program &prog,
+                          const opengl::material_binding::material &material,
+                          GLsizei instance_count, GLuint base_instance,
+                          size_t lod) {
+  return prepare_draw(prog, material, lod) &&
+         draw_elements_instanced(instance_count, base_instance, lod);
+}
+
+bool mesh::draw_elements(size_t lod) noexcept {
+  auto const &level = lod_levels[lod];
+  auto &statistics = render_statistics::get_current();
+  statistics.draw_calls++;
+  statistics.primitives += level.index_count / 3;
+  glDrawElements(
+      GL_TRIANGLES, static_cast<GLsizei>(level.index_count), GL_UNSIGNED_INT,
+      reinterpret_cast<void *>(level.first_index * sizeof(GLuint)));
+  if (check_error()) {
+    std::cerr << "glDrawElements failed" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool mesh::draw_elements_instanced(GLsizei instance_count,
+                                   GLuint base_instance, size_t lod) noexcept {
+  auto const &level = lod_levels[lod];
+  auto &statistics = render_statistics::get_current();
+  statistics.draw_calls++;
+  statistics.primitives +=
+      level.index_count / 3 * static_cast<size_t>(instance_count);
+  glDrawElementsInstancedBaseInstance(
+      GL_TRIANGLES, static_cast<GLsizei>(level.index_count), GL_UNSIGNED_INT,
+      reinterpret_cast<void *>(level.first_index * sizeof(GLuint)),
+      instance_count, base_instance);
+  if (check_error()) {
+    std::cerr << "glDrawElementsInstancedBaseInstance failed" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool mesh::prepare_vertex_array(opengl::program &prog, size_t lod) {
+  if (lod >= lod_levels.size()) {
+    std::cerr << "no level of detail " << lod << std::endl;
+    return false;
+  }
+  if constexpr (opengl::context::gl_minor_version >= 5) {
+    // the layout is shared; only the buffers are specific to this mesh
+    if (!VAO->set_vertex_buffer(vertex_binding, VBO, 0, sizeof(vertex)) ||
+        !VAO->set_element_buffer(EBO)) {
+      return false;
+    }
+    if (instance_VBO && !VAO->set_vertex_buffer(instance_binding,
+                                                *instance_VBO, 0,
+                                                sizeof(glm::mat4))) {
+      return false;
+    }
+  }
+  prog.set_vertex_array(*VAO);
+  return true;
+}
+
+bool mesh::prepare_draw(opengl::program &prog,
+                        const opengl::material_binding::material &material,
+                        size_t lod) {
+  if (!prepare_vertex_array(prog, lod)) {
+    return false;
+  }
+  for (auto const &[layer_uniform, layer] : material.layers) {
+    if (!layer_uniform->set(layer)) {
+      return false;
+    }
+  }
+  return prog.use(material.textures);
+}
+
+bool mesh::prepare_draw(
+    opengl::program &prog,
+    const std::map<texture_2D::type, std::vector<std::string>>
+        &texture_variable_names,
+    size_t lod) {
+  if (!prepare_vertex_array(prog, lod)) {
+    return false;
+  }
   prog.clear_textures();
   for (auto const &[type, variable_names] : texture_variable_names) {
+    auto layer_it = texture_layers.find(type);
+    if (layer_it != texture_layers.end()) {
+      auto const &layers = layer_it->second;
+      if (variable_names.size() > layers.size()) {
+        std::cerr << "more variable then texture:" << variable_names.size()
+                  << ' ' << layers.size() << std::endl;
+        return false;
+      }
+      for (size_t i = 0; i < variable_names.size(); i++) {
+        if (!prog.set_uniform(variable_names[i], layers[i].array)) {
+          return false;
+        }
+        auto name_it = layer_variable_names.find(variable_names[i]);
+        if (name_it == layer_variable_names.end()) {
+          name_it =
+              layer_variable_names
+                  .emplace(variable_names[i], variable_names[i] + "_layer")
+                  .first;
+        }
+        if (!prog.set_uniform(name_it->second, layers[i].layer)) {
+          return false;
+        }
+      }
+      continue;
+    }
+
     auto it = textures.find(type);
     if (it == textures.end()) {
       std::cerr << "no texture for type " << static_cast<int>(type)
@@ -73,15 +332,7 @@ bool mesh::draw(opengl::program &prog,
     }
   }
 
-  if (!prog.use()) {
-    return false;
-  }
-  glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
-  if (check_error()) {
-    std::cerr << "glDrawElements failed" << std::endl;
-    return false;
-  }
-  return true;
+  return prog.use();
 }
 
 } // namespace opengl
@@ -1,16 +1,23 @@
 #pragma once
 
+#include <algorithm>
 #include <cstddef>
+#include <cstdint>
 #include <glm/glm.hpp>
+#include <limits>
 #include <map>
+#include <memory>
 #include <stdexcept>
 #include <vector>
 
 #include "array_buffer.hpp"
 #include "element_array_buffer.hpp"
 #include "error.hpp"
+#include "material_binding.hpp"
+#include "memory_usage.hpp"
 #include "program.hpp"
 #include "texture.hpp"
+#include "vertex_layout.hpp"
 
 namespace opengl {
 
@@ -22,10 +29,34 @@ public:
     glm::vec3 normal;
     glm::vec2 texture_coord;
   };
+  static constexpr auto vertex_format = opengl::make_vertex_layout<vertex>(
+      opengl::attribute_of<glm::vec3>(0, offsetof(vertex, position)),
+      opengl::attribute_of<glm::vec3>(1, offsetof(vertex, normal)),
+      opengl::attribute_of<glm::vec2>(2, offsetof(vertex, texture_coord)));
+
+  struct bounding_sphere {
+    glm::vec3 center;
+    float radius;
+  };
+
+  // a layer of a texture array that is shared with other meshes
+  struct texture_layer {
+    opengl::texture_2D_array array;
+    GLint layer;
+  };
+
+  // whether vertices and indices stay in system memory after the upload, e.g.
+  // for picking or physics
+  enum class geometry_retention { release, keep };
 
 public:
+  // lod_indices_ are the simplified index lists of the coarser levels of
+  // detail, ordered from fine to coarse. They index into the same vertices and
+  // are stored behind indices_ in the same element array buffer.
   mesh(std::vector<vertex> vertices_, std::vector<GLuint> indices_,
-       std::map<texture_2D::type, std::vector<opengl::texture_2D>> textures_);
+       std::map<texture_2D::type, std::vector<opengl::texture_2D>> textures_,
+       std::vector<std::vector<GLuint>> lod_indices_ = {},
+       geometry_retention retention = geometry_retention::release);
 
   mesh(const mesh &) = delete;
   mesh &operator=(const mesh &) = delete;
@@ -37,13 +68,104 @@ public:
 
   bool draw(opengl::program &prog,
             const std::map<texture_2D::type, std::vector<std::string>>
-                &texture_variable_names);
+                &texture_variable_names,
+            size_t lod = 0);
+
+  // draw instance_count instances whose per-instance data starts at
+  // base_instance in the buffer given to set_instance_buffer
+  bool draw_instanced(opengl::program &prog,
+                      const std::map<texture_2D::type,
+                                     std::vector<std::string>>
+                          &texture_variable_names,
+                      GLsizei instance_count, GLuint base_instance,
+                      size_t lod = 0);
+
+  // draw with textures prepared by a material_binding built from prog
+  bool draw(opengl::program &prog,
+            const opengl::material_binding::material &material,
+            size_t lod = 0);
+  bool draw_instanced(opengl::program &prog,
+                      const opengl::material_binding::material &material,
+                      GLsizei instance_count, GLuint base_instance,
+                      size_t lod = 0);
+
+  // Sample textures of the given types from texture array layers instead.
+  // draw then binds the array to the texture variable and sets the layer
+  // index to an int uniform named after it with a "_layer" suffix.
+  void set_texture_layers(
+      std::map<texture_2D::type, std::vector<texture_layer>> layers);
+
+  // source a per-instance mat4 attribute at first_location (and the three
+  // locations after it) from a buffer of glm::mat4
+  bool set_instance_buffer(opengl::array_buffer<float> &instance_buffer,
+                           GLuint first_location);
+
+  size_t get_lod_count() const noexcept { return lod_levels.size(); }
+  // levels past the coarsest one count as the coarsest one
+  size_t get_triangle_count(size_t lod = 0) const noexcept {
+    return lod_levels[std::min(lod, lod_levels.size() - 1)].index_count / 3;
+  }
+  const bounding_sphere &get_bounding_sphere() const noexcept {
+    return bounds;
+  }
+
+  // equal for meshes that share a vertex array; sort draws by it to batch
+  uint64_t get_layout_hash() const noexcept { return layout_hash; }
+
+  // forward the on-screen size of this mesh to its streamed textures
+  void report_texture_footprint(float screen_pixels) const;
+
+  bool has_cpu_geometry() const noexcept { return cpu_geometry_retained; }
+  // empty unless the geometry is retained
+  gsl::span<const vertex> get_vertices() const noexcept { return vertices; }
+  gsl::span<const GLuint> get_indices(size_t lod = 0) const;
+  void release_cpu_geometry() noexcept;
+
+  // textures shared with other meshes are counted in full
+  opengl::memory_usage get_memory_usage(bool include_textures = true) const
+      noexcept;
+
+private:
+  static constexpr GLuint no_instance_attribute =
+      std::numeric_limits<GLuint>::max();
+  static std::shared_ptr<opengl::vertex_array>
+  get_layout_vertex_array(GLuint instance_location);
+
+  bool prepare_draw(opengl::program &prog,
+                    const std::map<texture_2D::type, std::vector<std::string>>
+                        &texture_variable_names,
+                    size_t lod);
+  bool prepare_draw(opengl::program &prog,
+                    const opengl::material_binding::material &material,
+                    size_t lod);
+  bool prepare_vertex_array(opengl::program &prog, size_t lod);
+  bool draw_elements(size_t lod) noexcept;
+  bool draw_elements_instanced(GLsizei instance_count, GLuint base_instance,
+                               size_t lod) noexcept;
+
+private:
+  friend class material_binding;
+
+  struct lod_level {
+    size_t first_index;
+    size_t index_count;
+  };
 
 private:
   std::vector<vertex> vertices;
   std::vector<GLuint> indices;
+  std::vector<lod_level> lod_levels;
+  bounding_sphere bounds{};
+  bool cpu_geometry_retained{true};
+  bool has_streamed_textures{false};
   std::map<texture_2D::type, std::vector<opengl::texture_2D>> textures;
-  opengl::vertex_array VAO{true};
+  std::map<texture_2D::type, std::vector<texture_layer>> texture_layers;
+  // "<variable>_layer" for each texture variable, built once
+  std::map<std::string, std::string, std::less<>> layer_variable_names;
+  // shared by all meshes with the same layout on OpenGL 4.5
+  std::shared_ptr<opengl::vertex_array> VAO;
+  uint64_t layout_hash{vertex_format.hash()};
+  opengl::array_buffer<float> *instance_VBO{};
   opengl::array_buffer<float> VBO;
   opengl::element_array_buffer<GLuint> EBO;
 };
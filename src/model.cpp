@@ -1,23 +1,36 @@
 
 #include <assimp/Importer.hpp>
 #include <assimp/postprocess.h>
+#include <algorithm>
+#include <array>
 #include <assimp/scene.h>
+#include <cmath>
 #include <filesystem>
 #include <iostream>
+#include <limits>
 #include <map>
+#include <numeric>
+#include <optional>
+#include <set>
 #include <stdexcept>
+#include <tuple>
 #include <utility>
 #include <vector>
 
+#include "material_binding.hpp"
 #include "mesh.hpp"
 #include "model.hpp"
+#include "profiler.hpp"
+#include "simplifier.hpp"
+#include "texture_cache.hpp"
 
 namespace opengl {
 
 class model::impl final {
 
 public:
-  explicit impl(std::filesystem::path model_file_) : model_file(model_file_) {
+  impl(std::filesystem::path model_file_, import_config config_)
+      : model_file(model_file_), config(config_) {
     if (!load()) {
       throw_exception(std::string("load model failed:") + model_file.string());
     }
@@ -31,30 +44,288 @@ public:
 
   ~impl() noexcept = default;
 
-  bool draw(opengl::program &prog,
-            const std::map<texture_2D::type, std::vector<std::string>>
-                &texture_variable_names) {
-    auto draw_mesh =
-        [&prog, &texture_variable_names](
-            auto &&self,
-            const std::unique_ptr<tree_node<opengl::mesh>> &node) -> bool {
-      for (auto &value : node->values) {
-        if (!value.draw(prog, texture_variable_names)) {
-          return false;
-        }
+  // textures_type is the texture variable name map or a material_binding
+  template <typename textures_type>
+  bool draw(opengl::program &prog, const textures_type &mesh_textures) {
+    return draw_nodes(prog, mesh_textures, glm::mat4(1.0f),
+                      [](const glm::mat4 &, const opengl::mesh &)
+                          -> std::optional<size_t> { return 0; });
+  }
+
+  template <typename textures_type>
+  bool draw(opengl::program &prog, const textures_type &mesh_textures,
+            const opengl::camera &view_camera, GLsizei viewport_width,
+            GLsizei viewport_height, const glm::mat4 &model_matrix) {
+    auto const tan_half_fov = std::tan(view_camera.get_fov() / 2);
+    auto const pixels_per_unit =
+        static_cast<float>(viewport_height) / tan_half_fov;
+    auto const aspect_ratio = static_cast<float>(viewport_width) /
+                              static_cast<float>(viewport_height);
+    // half angle of the cone enclosing the view frustum
+    auto const cone_angle = std::atan(
+        tan_half_fov * std::sqrt(1.0f + aspect_ratio * aspect_ratio));
+    auto const front = glm::normalize(view_camera.get_front());
+    auto const &position = view_camera.get_position();
+
+    return draw_nodes(
+        prog, mesh_textures, model_matrix,
+        [&](const glm::mat4 &transform,
+            const opengl::mesh &m) -> std::optional<size_t> {
+          auto const &sphere = m.get_bounding_sphere();
+          auto const center =
+              glm::vec3(transform * glm::vec4(sphere.center, 1.0f));
+          auto const radius = sphere.radius * get_max_scale(transform);
+          auto const direction = center - position;
+          auto const distance = glm::length(direction);
+          if (distance <= radius) {
+            return 0;
+          }
+          auto const angle = std::acos(std::clamp(
+              glm::dot(direction, front) / distance, -1.0f, 1.0f));
+          if (angle - std::asin(radius / distance) > cone_angle) {
+            return {};
+          }
+          auto const screen_pixels = radius / distance * pixels_per_unit;
+          m.report_texture_footprint(screen_pixels);
+          return select_lod(screen_pixels, m.get_lod_count());
+        });
+  }
+
+  const lod_statistics &get_lod_statistics() const noexcept {
+    return statistics;
+  }
+
+  void set_model_matrix_variable_name(std::string name) {
+    model_matrix_variable_name = std::move(name);
+  }
+
+  size_t get_node_count() const noexcept { return node_parents.size(); }
+
+  std::optional<size_t> find_node(const std::string &name) const {
+    auto it = std::find(node_names.begin(), node_names.end(), name);
+    if (it == node_names.end()) {
+      return {};
+    }
+    return it - node_names.begin();
+  }
+
+  bool set_node_transform(size_t node, const glm::mat4 &local_transform) {
+    if (node >= node_parents.size()) {
+      std::cerr << "no node " << node << std::endl;
+      return false;
+    }
+    node_local_transforms[node] = local_transform;
+    node_dirty[node] = true;
+    any_node_dirty = true;
+    return true;
+  }
+
+  const glm::mat4 &get_node_world_transform(size_t node) {
+    update_world_transforms();
+    return node_world_transforms.at(node);
+  }
+
+  gsl::span<const size_t> get_node_meshes(size_t node) const {
+    auto const [first, last] = node_mesh_ranges.at(node);
+    return gsl::span<const size_t>(node_mesh_indices.data() + first,
+                                   last - first);
+  }
+
+  template <typename textures_type>
+  bool draw_instanced(opengl::program &prog,
+                      const textures_type &mesh_textures) {
+    opengl::profiler::zone zone("model::draw_instanced");
+    if (!check_mesh_textures(mesh_textures)) {
+      return false;
+    }
+    update_world_transforms();
+    if (instance_transforms_dirty) {
+      for (size_t i = 0; i < instance_nodes.size(); i++) {
+        instance_transforms[i] = node_world_transforms[instance_nodes[i]];
+      }
+      if (!instance_buffer.write(instance_transforms)) {
+        return false;
+      }
+      instance_transforms_dirty = false;
+    }
+
+    statistics = {};
+    for (size_t i = 0; i < meshes.size(); i++) {
+      auto const first_instance = mesh_instance_offsets[i];
+      auto const instance_count = mesh_instance_offsets[i + 1] - first_instance;
+      if (instance_count == 0) {
+        continue;
+      }
+      auto const triangles = meshes[i].get_triangle_count() * instance_count;
+      statistics.drawn_triangles += triangles;
+      statistics.full_detail_triangles += triangles;
+      if (!meshes[i].draw_instanced(prog, get_mesh_textures(mesh_textures, i),
+                                    static_cast<GLsizei>(instance_count),
+                                    static_cast<GLuint>(first_instance))) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  size_t get_mesh_count() const noexcept { return meshes.size(); }
+
+  const opengl::mesh &get_mesh(size_t index) const {
+    return meshes.at(index);
+  }
+
+  opengl::memory_usage get_memory_usage() const noexcept {
+    opengl::memory_usage usage;
+    for (auto const &m : meshes) {
+      usage += m.get_memory_usage(false);
+    }
+    for (auto const &[_, texture] : loaded_textures) {
+      usage.gpu_bytes += texture.get_memory_size();
+    }
+    for (auto const &array : material_arrays) {
+      usage.gpu_bytes += array.get_memory_size();
+    }
+    usage.cpu_bytes +=
+        node_parents.capacity() * sizeof(size_t) +
+        (node_local_transforms.capacity() +
+         node_world_transforms.capacity()) *
+            sizeof(glm::mat4) +
+        node_mesh_ranges.capacity() * sizeof(std::pair<size_t, size_t>) +
+        meshes.capacity() * sizeof(opengl::mesh) +
+        (node_mesh_indices.capacity() + mesh_instance_offsets.capacity() +
+         instance_nodes.capacity()) *
+            sizeof(size_t) +
+        instance_transforms.capacity() * sizeof(glm::mat4);
+    usage.gpu_bytes += instance_buffer.get_size();
+    return usage;
+  }
+
+private:
+  // select returns the level of detail to draw a mesh at, or nothing to cull
+  // it
+  template <typename textures_type, typename F>
+  bool draw_nodes(opengl::program &prog, const textures_type &mesh_textures,
+                  const glm::mat4 &model_matrix, F &&select) {
+    opengl::profiler::zone zone("model::draw");
+    if (!check_mesh_textures(mesh_textures)) {
+      return false;
+    }
+    update_world_transforms();
+    statistics = {};
+    for (size_t i = 0; i < node_parents.size(); i++) {
+      auto const [first_mesh, last_mesh] = node_mesh_ranges[i];
+      if (first_mesh == last_mesh) {
+        continue;
       }
-      for (const auto &child : node->children) {
-        if (!self(self, child)) {
+      auto const transform = model_matrix * node_world_transforms[i];
+      bool transform_assigned = false;
+      for (auto j = first_mesh; j < last_mesh; j++) {
+        auto const mesh_index = node_mesh_indices[j];
+        auto &m = meshes[mesh_index];
+        statistics.full_detail_triangles += m.get_triangle_count();
+        auto const lod = select(transform, m);
+        if (!lod) {
+          statistics.culled_meshes++;
+          continue;
+        }
+        if (!transform_assigned && !model_matrix_variable_name.empty()) {
+          if (!prog.set_uniform(model_matrix_variable_name, transform)) {
+            return false;
+          }
+          transform_assigned = true;
+        }
+        statistics.drawn_triangles += m.get_triangle_count(*lod);
+        if (!m.draw(prog, get_mesh_textures(mesh_textures, mesh_index),
+                    *lod)) {
           return false;
         }
       }
-      return true;
-    };
+    }
+    return true;
+  }
 
-    return draw_mesh(draw_mesh, meshes);
+  static const std::map<texture_2D::type, std::vector<std::string>> &
+  get_mesh_textures(const std::map<texture_2D::type, std::vector<std::string>>
+                        &texture_variable_names,
+                    size_t) noexcept {
+    return texture_variable_names;
+  }
+  static const opengl::material_binding::material &
+  get_mesh_textures(const opengl::material_binding &binding,
+                    size_t mesh_index) {
+    return binding.get_material(mesh_index);
+  }
+
+  bool check_mesh_textures(
+      const std::map<texture_2D::type, std::vector<std::string>> &) const
+      noexcept {
+    return true;
+  }
+  bool check_mesh_textures(const opengl::material_binding &binding) const
+      noexcept {
+    if (binding.get_material_count() != meshes.size()) {
+      std::cerr << "material binding is not built from this model"
+                << std::endl;
+      return false;
+    }
+    return true;
+  }
+
+  // parents precede their children, so one linear pass propagates the dirty
+  // flags and recomputes every affected world transform
+  void update_world_transforms() noexcept {
+    if (!any_node_dirty) {
+      return;
+    }
+    for (size_t i = 0; i < node_parents.size(); i++) {
+      auto const parent = node_parents[i];
+      if (parent != no_parent && node_dirty[parent]) {
+        node_dirty[i] = true;
+      }
+      if (!node_dirty[i]) {
+        continue;
+      }
+      if (parent == no_parent) {
+        node_world_transforms[i] = node_local_transforms[i];
+      } else {
+        node_world_transforms[i] =
+            node_world_transforms[parent] * node_local_transforms[i];
+      }
+    }
+    std::fill(node_dirty.begin(), node_dirty.end(), false);
+    any_node_dirty = false;
+    instance_transforms_dirty = true;
+  }
+
+  static float get_max_scale(const glm::mat4 &transform) noexcept {
+    return std::max({glm::length(glm::vec3(transform[0])),
+                     glm::length(glm::vec3(transform[1])),
+                     glm::length(glm::vec3(transform[2]))});
+  }
+
+  static glm::mat4 convert_assimp_matrix(const ::aiMatrix4x4 &m) noexcept {
+    // assimp matrices are row-major, glm ones column-major
+    glm::mat4 result;
+    result[0] = glm::vec4(m.a1, m.b1, m.c1, m.d1);
+    result[1] = glm::vec4(m.a2, m.b2, m.c2, m.d2);
+    result[2] = glm::vec4(m.a3, m.b3, m.c3, m.d3);
+    result[3] = glm::vec4(m.a4, m.b4, m.c4, m.d4);
+    return result;
+  }
+
+  // Each level keeps lod_index_ratio of the triangles of the previous one, so
+  // switching when the projected area shrinks by the same ratio keeps the
+  // triangle density on screen roughly constant.
+  size_t select_lod(float screen_height, size_t lod_count) const noexcept {
+    if (screen_height >= config.lod_screen_height || lod_count <= 1) {
+      return 0;
+    }
+    auto const level =
+        std::log(config.lod_screen_height / screen_height) /
+        std::log(1.0f / std::sqrt(config.lod_index_ratio));
+    return std::min(static_cast<size_t>(level), lod_count - 1);
   }
 
-private:
   bool load() {
 
     if (!std::filesystem::exists(model_file)) {
@@ -73,24 +344,84 @@ private:
       return false;
     }
 
-    auto process_node =
-        [&scene,
-         this](auto &&self, auto assimp_node,
-               std::unique_ptr<tree_node<opengl::mesh>> &new_node) -> void {
-      new_node = std::make_unique<tree_node<opengl::mesh>>();
-      for (size_t i = 0; i < assimp_node->mNumMeshes; i++) {
-        auto mesh = scene->mMeshes[assimp_node->mMeshes[i]];
-        new_node->values.emplace_back(convert_assimp_mesh(*mesh, *scene));
+    if (config.texture_arrays && !pack_material_textures(*scene)) {
+      return false;
+    }
+
+    // convert and upload each mesh once, however many nodes reference it
+    meshes.reserve(scene->mNumMeshes);
+    for (size_t i = 0; i < scene->mNumMeshes; i++) {
+      meshes.emplace_back(convert_assimp_mesh(*scene->mMeshes[i], *scene));
+    }
+
+    // flatten the hierarchy in depth-first order
+    std::vector<std::pair<const ::aiNode *, size_t>> pending{
+        {scene->mRootNode, no_parent}};
+    while (!pending.empty()) {
+      auto const [assimp_node, parent] = pending.back();
+      pending.pop_back();
+
+      auto const index = node_parents.size();
+      node_parents.push_back(parent);
+      node_names.emplace_back(assimp_node->mName.C_Str());
+      node_local_transforms.push_back(
+          convert_assimp_matrix(assimp_node->mTransformation));
+      node_world_transforms.push_back(node_local_transforms.back());
+      node_dirty.push_back(true);
+
+      auto const first_mesh = node_mesh_indices.size();
+      node_mesh_indices.insert(node_mesh_indices.end(), assimp_node->mMeshes,
+                               assimp_node->mMeshes + assimp_node->mNumMeshes);
+      node_mesh_ranges.emplace_back(first_mesh, node_mesh_indices.size());
+
+      // push in reverse so that children are visited in their original order
+      for (auto i = assimp_node->mNumChildren; i > 0; i--) {
+        pending.emplace_back(assimp_node->mChildren[i - 1], index);
       }
-      // then do the same for each of its children
-      for (size_t i = 0; i < assimp_node->mNumChildren; i++) {
-        std::unique_ptr<tree_node<opengl::mesh>> child;
-        self(self, assimp_node->mChildren[i], child);
-        new_node->children.emplace_back(std::move(child));
+    }
+    any_node_dirty = true;
+
+    return group_instances();
+  }
+
+  // group the node references by mesh for instanced drawing, and upload the
+  // world transforms of the instances
+  bool group_instances() {
+    mesh_instance_offsets.assign(meshes.size() + 1, 0);
+    for (auto mesh_index : node_mesh_indices) {
+      mesh_instance_offsets[mesh_index + 1]++;
+    }
+    std::partial_sum(mesh_instance_offsets.begin(),
+                     mesh_instance_offsets.end(),
+                     mesh_instance_offsets.begin());
+    instance_nodes.resize(node_mesh_indices.size());
+    auto next_instance = mesh_instance_offsets;
+    for (size_t node_index = 0; node_index < node_mesh_ranges.size();
+         node_index++) {
+      auto const [first, last] = node_mesh_ranges[node_index];
+      for (auto i = first; i < last; i++) {
+        instance_nodes[next_instance[node_mesh_indices[i]]++] = node_index;
       }
-    };
+    }
 
-    process_node(process_node, scene->mRootNode, meshes);
+    if (instance_nodes.empty()) {
+      return true;
+    }
+    update_world_transforms();
+    instance_transforms.resize(instance_nodes.size());
+    for (size_t i = 0; i < instance_nodes.size(); i++) {
+      instance_transforms[i] = node_world_transforms[instance_nodes[i]];
+    }
+    if (!instance_buffer.write(instance_transforms)) {
+      return false;
+    }
+    instance_transforms_dirty = false;
+    for (auto &m : meshes) {
+      if (!m.set_instance_buffer(instance_buffer,
+                                 config.instance_attribute_location)) {
+        return false;
+      }
+    }
     return true;
   }
 
@@ -128,37 +459,135 @@ private:
         indices.push_back(face.mIndices[j]);
     }
 
+    std::vector<std::vector<GLuint>> lod_indices;
+    if (config.lod_count > 1) {
+      std::vector<glm::vec3> positions;
+      positions.reserve(vertices.size());
+      for (auto const &v : vertices) {
+        positions.push_back(v.position);
+      }
+      lod_indices.reserve(config.lod_count - 1);
+      const std::vector<GLuint> *previous = &indices;
+      for (size_t level = 1; level < config.lod_count; level++) {
+        auto target_index_count =
+            static_cast<size_t>(previous->size() * config.lod_index_ratio);
+        target_index_count -= target_index_count % 3;
+        auto simplified = opengl::simplify_indices(
+            positions, *previous, target_index_count, config.lod_max_error);
+        // stop when the error bound prevents any significant reduction
+        if (simplified.empty() ||
+            simplified.size() > previous->size() * 0.9) {
+          break;
+        }
+        lod_indices.emplace_back(std::move(simplified));
+        previous = &lod_indices.back();
+      }
+    }
+
     std::map<opengl::texture_2D::type, std::vector<opengl::texture_2D>>
         textures;
+    std::map<opengl::texture_2D::type, std::vector<opengl::mesh::texture_layer>>
+        texture_layers;
     auto const material = assimp_scene.mMaterials[assimp_mesh.mMaterialIndex];
-    textures[opengl::texture_2D::type::diffuse] =
-        load_assimp_texture(*material, aiTextureType_DIFFUSE);
-    textures[opengl::texture_2D::type::specular] =
-        load_assimp_texture(*material, aiTextureType_SPECULAR);
-    return ::opengl::mesh(vertices, indices, textures);
+    for (auto const &[type, assimp_type, usage] : material_texture_types) {
+      if (config.texture_arrays) {
+        auto &layers = texture_layers[type];
+        for (auto const &path :
+             get_assimp_texture_paths(*material, assimp_type)) {
+          layers.push_back(packed_textures.at({path, usage}));
+        }
+      } else {
+        textures[type] = load_assimp_texture(*material, assimp_type, usage);
+      }
+    }
+    ::opengl::mesh result(std::move(vertices), std::move(indices), textures,
+                          std::move(lod_indices), config.retention);
+    if (config.texture_arrays) {
+      result.set_texture_layers(std::move(texture_layers));
+    }
+    return result;
   }
 
-  std::vector<opengl::texture_2D>
-  load_assimp_texture(const ::aiMaterial &material, ::aiTextureType type) {
-    std::vector<opengl::texture_2D> textures;
+  std::vector<std::filesystem::path>
+  get_assimp_texture_paths(const ::aiMaterial &material,
+                           ::aiTextureType type) const {
+    std::vector<std::filesystem::path> paths;
     for (size_t i = 0; i < material.GetTextureCount(type); i++) {
       aiString file_path;
       material.GetTexture(type, i, &file_path);
-      auto abs_path = std::filesystem::absolute(model_file.parent_path() /
-                                                file_path.C_Str());
+      paths.emplace_back(std::filesystem::absolute(model_file.parent_path() /
+                                                   file_path.C_Str()));
+    }
+    return paths;
+  }
 
-      opengl::texture_2D::extra_config config;
-      config.flip_y = false;
-      auto [it, has_emplaced] =
-          loaded_textures.try_emplace(abs_path, abs_path, config);
-      if (has_emplaced) {
-        if (!it->second.set_parameter(GL_TEXTURE_MIN_FILTER, GL_LINEAR)) {
-          throw_exception("set GL_TEXTURE_MIN_FILTER failed");
+  // group the material textures of the scene by usage, size and layout, and
+  // load each group as one texture array
+  bool pack_material_textures(const ::aiScene &assimp_scene) {
+    // GL_MAX_ARRAY_TEXTURE_LAYERS is at least 256 in OpenGL 3.0 and later
+    constexpr size_t max_layers = 256;
+    using group_key =
+        std::tuple<opengl::texture_2D::usage, int, int, int, bool>;
+    std::map<group_key, std::vector<std::filesystem::path>> groups;
+    std::set<std::pair<std::filesystem::path, opengl::texture_2D::usage>>
+        seen;
+
+    for (size_t i = 0; i < assimp_scene.mNumMaterials; i++) {
+      auto const &material = *assimp_scene.mMaterials[i];
+      for (auto const &[_, assimp_type, usage] : material_texture_types) {
+        for (auto const &path : get_assimp_texture_paths(material,
+                                                         assimp_type)) {
+          if (!seen.emplace(path, usage).second) {
+            continue;
+          }
+          int width = 0, height = 0, channel = 0;
+          if (!stbi_info(path.string().c_str(), &width, &height, &channel)) {
+            std::cerr << "stbi_info " << path << " failed" << std::endl;
+            return false;
+          }
+          auto const is_16_bit = stbi_is_16_bit(path.string().c_str()) != 0;
+          groups[{usage, width, height, channel, is_16_bit}].push_back(path);
         }
+      }
+    }
 
-        if (!it->second.set_parameter(GL_TEXTURE_MAG_FILTER, GL_LINEAR)) {
-          throw_exception("set GL_TEXTURE_MAG_FILTER failed");
+    for (auto const &[key, paths] : groups) {
+      opengl::texture_2D::extra_config texture_config;
+      texture_config.flip_y = false;
+      texture_config.image_usage = std::get<0>(key);
+      for (size_t first = 0; first < paths.size(); first += max_layers) {
+        std::vector<std::filesystem::path> layer_paths(
+            paths.begin() + first,
+            paths.begin() + std::min(first + max_layers, paths.size()));
+        opengl::texture_2D_array array(layer_paths, texture_config);
+        for (size_t layer = 0; layer < layer_paths.size(); layer++) {
+          packed_textures.emplace(
+              std::pair{layer_paths[layer], texture_config.image_usage},
+              opengl::mesh::texture_layer{array, static_cast<GLint>(layer)});
         }
+        material_arrays.push_back(std::move(array));
+      }
+    }
+    return true;
+  }
+
+  std::vector<opengl::texture_2D>
+  load_assimp_texture(const ::aiMaterial &material, ::aiTextureType type,
+                      opengl::texture_2D::usage usage) {
+    std::vector<opengl::texture_2D> textures;
+    for (auto const &abs_path : get_assimp_texture_paths(material, type)) {
+      opengl::texture_2D::extra_config config;
+      config.flip_y = false;
+      config.streaming = this->config.stream_textures;
+      config.image_usage = usage;
+      // the texture_2D constructor already sets linear filtering
+      auto key = std::pair{abs_path, usage};
+      auto it = loaded_textures.find(key);
+      if (it == loaded_textures.end()) {
+        it = loaded_textures
+                 .emplace(key, opengl::texture_cache::instance().get(
+                                   abs_path, config))
+                 .first;
       }
       textures.push_back(it->second);
     }
@@ -167,16 +596,55 @@ private:
 
 private:
   std::filesystem::path model_file;
-  template <typename T> struct tree_node {
-    std::vector<T> values;
-    std::vector<std::unique_ptr<tree_node>> children;
-  };
-  std::unique_ptr<tree_node<opengl::mesh>> meshes;
+  static constexpr size_t no_parent = std::numeric_limits<size_t>::max();
+  static constexpr std::array<std::tuple<opengl::texture_2D::type,
+                                         ::aiTextureType,
+                                         opengl::texture_2D::usage>,
+                              2>
+      material_texture_types{{
+          {opengl::texture_2D::type::diffuse, aiTextureType_DIFFUSE,
+           opengl::texture_2D::usage::color},
+          {opengl::texture_2D::type::specular, aiTextureType_SPECULAR,
+           opengl::texture_2D::usage::data},
+      }};
+
+  // scene nodes as parallel arrays in topological order
+  std::vector<size_t> node_parents;
+  std::vector<std::string> node_names;
+  std::vector<glm::mat4> node_local_transforms;
+  std::vector<glm::mat4> node_world_transforms;
+  // [first, last) into node_mesh_indices
+  std::vector<std::pair<size_t, size_t>> node_mesh_ranges;
+  std::vector<bool> node_dirty;
+  bool any_node_dirty{false};
+
+  // one entry per scene mesh, shared by every node referencing it
+  std::vector<opengl::mesh> meshes;
+  std::vector<size_t> node_mesh_indices;
 
-  std::map<std::filesystem::path, opengl::texture_2D> loaded_textures;
+  // instances of mesh i are [mesh_instance_offsets[i],
+  // mesh_instance_offsets[i + 1]) in instance_nodes and instance_buffer
+  std::vector<size_t> mesh_instance_offsets;
+  std::vector<size_t> instance_nodes;
+  std::vector<glm::mat4> instance_transforms;
+  opengl::array_buffer<float> instance_buffer;
+  bool instance_transforms_dirty{true};
+  std::string model_matrix_variable_name;
+  import_config config;
+  lod_statistics statistics;
+
+  std::map<std::pair<std::filesystem::path, opengl::texture_2D::usage>,
+           opengl::texture_2D>
+      loaded_textures;
+  // material textures packed into arrays when import_config::texture_arrays
+  std::vector<opengl::texture_2D_array> material_arrays;
+  std::map<std::pair<std::filesystem::path, opengl::texture_2D::usage>,
+           opengl::mesh::texture_layer>
+      packed_textures;
 };
 
-model::model(std::filesystem::path model_file) : pimpl(new impl(model_file)) {}
+model::model(std::filesystem::path model_file, import_config config)
+    : pimpl(new impl(model_file, config)) {}
 
 model::~model() = default;
 
@@ -186,4 +654,78 @@ bool model::draw(opengl::program &prog,
   return pimpl->draw(prog, texture_variable_names);
 }
 
+bool model::draw(opengl::program &prog,
+                 const std::map<texture_2D::type, std::vector<std::string>>
+                     &texture_variable_names,
+                 const opengl::camera &view_camera, GLsizei viewport_width,
+                 GLsizei viewport_height, const glm::mat4 &model_matrix) {
+  return pimpl->draw(prog, texture_variable_names, view_camera,
+                     viewport_width, viewport_height, model_matrix);
+}
+
+bool model::draw(opengl::program &prog,
+                 const opengl::material_binding &binding) {
+  return pimpl->draw(prog, binding);
+}
+
+bool model::draw(opengl::program &prog,
+                 const opengl::material_binding &binding,
+                 const opengl::camera &view_camera, GLsizei viewport_width,
+                 GLsizei viewport_height, const glm::mat4 &model_matrix) {
+  return pimpl->draw(prog, binding, view_camera, viewport_width,
+                     viewport_height, model_matrix);
+}
+
+const model::lod_statistics &model::get_lod_statistics() const noexcept {
+  return pimpl->get_lod_statistics();
+}
+
+void model::set_model_matrix_variable_name(std::string name) {
+  pimpl->set_model_matrix_variable_name(std::move(name));
+}
+
+size_t model::get_node_count() const noexcept {
+  return pimpl->get_node_count();
+}
+
+std::optional<size_t> model::find_node(const std::string &name) const {
+  return pimpl->find_node(name);
+}
+
+bool model::set_node_transform(size_t node, const glm::mat4 &local_transform) {
+  return pimpl->set_node_transform(node, local_transform);
+}
+
+const glm::mat4 &model::get_node_world_transform(size_t node) {
+  return pimpl->get_node_world_transform(node);
+}
+
+gsl::span<const size_t> model::get_node_meshes(size_t node) const {
+  return pimpl->get_node_meshes(node);
+}
+
+bool model::draw_instanced(
+    opengl::program &prog,
+    const std::map<texture_2D::type, std::vector<std::string>>
+        &texture_variable_names) {
+  return pimpl->draw_instanced(prog, texture_variable_names);
+}
+
+bool model::draw_instanced(opengl::program &prog,
+                           const opengl::material_binding &binding) {
+  return pimpl->draw_instanced(prog, binding);
+}
+
+size_t model::get_mesh_count() const noexcept {
+  return pimpl->get_mesh_count();
+}
+
+const opengl::mesh &model::get_mesh(size_t index) const {
+  return pimpl->get_mesh(index);
+}
+
+opengl::memory_usage model::get_memory_usage() const noexcept {
+  return pimpl->get_memory_usage();
+}
+
 } // namespace opengl
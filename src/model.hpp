@@ -6,10 +6,14 @@
 #include <filesystem>
 #include <iostream>
 #include <map>
+#include <optional>
 #include <stdexcept>
+#include <tuple>
 #include <utility>
 #include <vector>
 
+#include "camera.hpp"
+#include "material_binding.hpp"
 #include "mesh.hpp"
 
 namespace opengl {
@@ -17,7 +21,55 @@ namespace opengl {
 class model final {
 
 public:
-  explicit model(std::filesystem::path model_file);
+  struct import_config {
+    import_config()
+        : lod_count{1}, lod_index_ratio{0.5f}, lod_max_error{0.01f},
+          lod_screen_height{256.0f},
+          retention{opengl::mesh::geometry_retention::release},
+          instance_attribute_location{3}, stream_textures{false},
+          texture_arrays{false} {}
+    // number of levels of detail per mesh, including the full-detail one;
+    // each further level is simplified from the previous one during import
+    size_t lod_count;
+    // index count of each level relative to the previous one
+    float lod_index_ratio;
+    // simplification error bound, relative to the extent of the mesh
+    float lod_max_error;
+    // projected height in pixels from which on the full-detail level is drawn
+    float lod_screen_height;
+    // keep vertices and indices in system memory after the upload
+    opengl::mesh::geometry_retention retention;
+    // first of the four locations of the per-instance mat4 attribute read by
+    // draw_instanced
+    GLuint instance_attribute_location;
+    // load material textures through texture_streamer
+    bool stream_textures;
+    // pack material textures of the same size into texture array layers;
+    // see mesh::set_texture_layers for what the shader has to declare
+    bool texture_arrays;
+
+  private:
+    auto tie() const noexcept {
+      return std::tie(lod_count, lod_index_ratio, lod_max_error,
+                      lod_screen_height, retention,
+                      instance_attribute_location, stream_textures,
+                      texture_arrays);
+    }
+
+  public:
+    bool operator<(const import_config &rhs) const noexcept {
+      return tie() < rhs.tie();
+    }
+  };
+
+  struct lod_statistics {
+    size_t drawn_triangles{};
+    size_t full_detail_triangles{};
+    size_t culled_meshes{};
+  };
+
+public:
+  explicit model(std::filesystem::path model_file, import_config config = {});
 
   model(const model &) = delete;
   model &operator=(const model &) = delete;
@@ -31,6 +83,53 @@ public:
             const std::map<texture_2D::type, std::vector<std::string>>
                 &texture_variable_names);
 
+  // draw each visible mesh at the level of detail matching its projected
+  // size
+  bool draw(opengl::program &prog,
+            const std::map<texture_2D::type, std::vector<std::string>>
+                &texture_variable_names,
+            const opengl::camera &view_camera, GLsizei viewport_width,
+            GLsizei viewport_height,
+            const glm::mat4 &model_matrix = glm::mat4(1.0f));
+
+  // Draw every mesh once for all nodes referencing it. The node world
+  // transforms are passed per instance in a mat4 vertex attribute at
+  // import_config::instance_attribute_location.
+  bool draw_instanced(opengl::program &prog,
+                      const std::map<texture_2D::type,
+                                     std::vector<std::string>>
+                          &texture_variable_names);
+
+  // the draw calls above with the textures prepared by a material_binding
+  // built from prog and this model
+  bool draw(opengl::program &prog, const opengl::material_binding &binding);
+  bool draw(opengl::program &prog, const opengl::material_binding &binding,
+            const opengl::camera &view_camera, GLsizei viewport_width,
+            GLsizei viewport_height,
+            const glm::mat4 &model_matrix = glm::mat4(1.0f));
+  bool draw_instanced(opengl::program &prog,
+                      const opengl::material_binding &binding);
+
+  // triangle counts of the last draw call
+  const lod_statistics &get_lod_statistics() const noexcept;
+
+  // when set, the world transform of each scene node is assigned to this
+  // uniform before its meshes are drawn
+  void set_model_matrix_variable_name(std::string name);
+
+  size_t get_node_count() const noexcept;
+  std::optional<size_t> find_node(const std::string &name) const;
+  bool set_node_transform(size_t node, const glm::mat4 &local_transform);
+  const glm::mat4 &get_node_world_transform(size_t node);
+  // indices of the meshes referenced by a node
+  gsl::span<const size_t> get_node_meshes(size_t node) const;
+
+  size_t get_mesh_count() const noexcept;
+  const opengl::mesh &get_mesh(size_t index) const;
+
+  // textures shared between meshes are counted once
+  opengl::memory_usage get_memory_usage() const noexcept;
+
 private:
   class impl;
   std::unique_ptr<impl> pimpl;
@@ -0,0 +1,83 @@
+
+#include <exception>
+#include <iostream>
+
+#include "model_manager.hpp"
+
+namespace opengl {
+
+std::shared_ptr<opengl::model>
+model_manager::load(const std::filesystem::path &model_file,
+                    opengl::model::import_config config) {
+  if (!std::filesystem::exists(model_file)) {
+    throw_exception(std::string("no model file:") + model_file.string());
+  }
+  key_type key{std::filesystem::canonical(model_file), config};
+
+  std::promise<std::shared_ptr<opengl::model>> promise;
+  std::shared_future<std::shared_ptr<opengl::model>> loading;
+  {
+    std::lock_guard lock(shared_state->mutex);
+    auto &e = shared_state->entries[key];
+    if (auto handle = e.handle.lock()) {
+      return handle;
+    }
+    if (e.loading.valid()) {
+      loading = e.loading;
+    } else {
+      e.loading = promise.get_future().share();
+    }
+  }
+  if (loading.valid()) {
+    return loading.get();
+  }
+
+  std::shared_ptr<opengl::model> handle;
+  try {
+    std::weak_ptr<state> weak_state = shared_state;
+    handle.reset(new opengl::model(key.first, config),
+                 [weak_state, key](opengl::model *ptr) {
+                   delete ptr;
+                   auto s = weak_state.lock();
+                   if (!s) {
+                     return;
+                   }
+                   std::lock_guard lock(s->mutex);
+                   auto it = s->entries.find(key);
+                   // a new load may have started after the last handle died
+                   if (it != s->entries.end() && it->second.handle.expired() &&
+                       !it->second.loading.valid()) {
+                     s->entries.erase(it);
+                   }
+                 });
+  } catch (...) {
+    {
+      std::lock_guard lock(shared_state->mutex);
+      shared_state->entries.erase(key);
+    }
+    promise.set_exception(std::current_exception());
+    throw;
+  }
+
+  {
+    std::lock_guard lock(shared_state->mutex);
+    auto &e = shared_state->entries[key];
+    e.handle = handle;
+    e.loading = {};
+  }
+  promise.set_value(handle);
+  return handle;
+}
+
+size_t model_manager::get_loaded_count() const {
+  std::lock_guard lock(shared_state->mutex);
+  size_t count = 0;
+  for (auto const &[_, e] : shared_state->entries) {
+    if (!e.handle.expired()) {
+      count++;
+    }
+  }
+  return count;
+}
+
+} // namespace opengl
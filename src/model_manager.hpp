@@ -0,0 +1,58 @@
+#pragma once
+
+#include <filesystem>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+#include "model.hpp"
+
+namespace opengl {
+
+// Hands out shared handles to models, so that each file is imported and
+// uploaded once per import config. A model is unloaded when its last handle
+// goes away.
+class model_manager final {
+
+public:
+  model_manager() = default;
+
+  model_manager(const model_manager &) = delete;
+  model_manager &operator=(const model_manager &) = delete;
+
+  model_manager(model_manager &&) noexcept = delete;
+  model_manager &operator=(model_manager &&) noexcept = delete;
+
+  ~model_manager() noexcept = default;
+
+  // The model is loaded on the calling thread, which must have a current
+  // context. Concurrent requests for the same model wait for that load
+  // instead of starting their own.
+  std::shared_ptr<opengl::model>
+  load(const std::filesystem::path &model_file,
+       opengl::model::import_config config = {});
+
+  size_t get_loaded_count() const;
+
+private:
+  using key_type =
+      std::pair<std::filesystem::path, opengl::model::import_config>;
+
+  struct entry {
+    std::weak_ptr<opengl::model> handle;
+    std::shared_future<std::shared_ptr<opengl::model>> loading;
+  };
+
+  // outlives the manager if handles do, so their deleters stay valid
+  struct state {
+    std::mutex mutex;
+    std::map<key_type, entry> entries;
+  };
+
+private:
+  std::shared_ptr<state> shared_state{std::make_shared<state>()};
+};
+
+} // namespace opengl
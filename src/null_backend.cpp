@@ -0,0 +1,549 @@
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "context.hpp"
+#include "null_backend.hpp"
+
+namespace opengl {
+
+namespace {
+// every GL function the library calls
+#define OPENGL_NULL_BACKEND_FUNCTIONS(X)                                       \
+  X(ActiveTexture)                                                             \
+  X(AttachShader)                                                              \
+  X(BeginQuery)                                                                \
+  X(BindBuffer)                                                                \
+  X(BindBufferBase)                                                            \
+  X(BindBufferRange)                                                           \
+  X(BindFramebuffer)                                                           \
+  X(BindRenderbuffer)                                                          \
+  X(BindSampler)                                                               \
+  X(BindSamplers)                                                              \
+  X(BindTexture)                                                               \
+  X(BindTextureUnit)                                                           \
+  X(BindTextures)                                                              \
+  X(BindVertexArray)                                                           \
+  X(BlendFunc)                                                                 \
+  X(BufferData)                                                                \
+  X(BufferSubData)                                                             \
+  X(CheckFramebufferStatus)                                                    \
+  X(CheckNamedFramebufferStatus)                                               \
+  X(Clear)                                                                     \
+  X(ClearColor)                                                                \
+  X(CompileShader)                                                             \
+  X(CreateBuffers)                                                             \
+  X(CreateFramebuffers)                                                        \
+  X(CreateProgram)                                                             \
+  X(CreateRenderbuffers)                                                       \
+  X(CreateSamplers)                                                            \
+  X(CreateShader)                                                              \
+  X(CreateTextures)                                                            \
+  X(CreateVertexArrays)                                                        \
+  X(CullFace)                                                                  \
+  X(DebugMessageCallback)                                                      \
+  X(DebugMessageControl)                                                       \
+  X(DeleteBuffers)                                                             \
+  X(DeleteFramebuffers)                                                        \
+  X(DeleteProgram)                                                             \
+  X(DeleteQueries)                                                             \
+  X(DeleteRenderbuffers)                                                       \
+  X(DeleteSamplers)                                                            \
+  X(DeleteShader)                                                              \
+  X(DeleteTextures)                                                            \
+  X(DeleteVertexArrays)                                                        \
+  X(DepthFunc)                                                                 \
+  X(DepthMask)                                                                 \
+  X(DetachShader)                                                              \
+  X(Disable)                                                                   \
+  X(DrawElements)                                                              \
+  X(DrawElementsInstancedBaseInstance)                                         \
+  X(Enable)                                                                    \
+  X(EnableVertexArrayAttrib)                                                   \
+  X(EnableVertexAttribArray)                                                   \
+  X(EndQuery)                                                                  \
+  X(Finish)                                                                    \
+  X(FramebufferRenderbuffer)                                                   \
+  X(FramebufferTexture2D)                                                      \
+  X(GenBuffers)                                                                \
+  X(GenFramebuffers)                                                           \
+  X(GenQueries)                                                                \
+  X(GenRenderbuffers)                                                          \
+  X(GenSamplers)                                                               \
+  X(GenTextures)                                                               \
+  X(GenVertexArrays)                                                           \
+  X(GenerateMipmap)                                                            \
+  X(GenerateTextureMipmap)                                                     \
+  X(GetActiveUniform)                                                          \
+  X(GetActiveUniformBlockName)                                                 \
+  X(GetActiveUniformBlockiv)                                                   \
+  X(GetActiveUniformName)                                                      \
+  X(GetActiveUniformsiv)                                                       \
+  X(GetBufferSubData)                                                          \
+  X(GetError)                                                                  \
+  X(GetInteger64v)                                                             \
+  X(GetIntegerv)                                                               \
+  X(GetNamedBufferSubData)                                                     \
+  X(GetProgramInfoLog)                                                         \
+  X(GetProgramInterfaceiv)                                                     \
+  X(GetProgramResourceIndex)                                                   \
+  X(GetProgramResourceName)                                                    \
+  X(GetProgramiv)                                                              \
+  X(GetQueryObjectiv)                                                          \
+  X(GetQueryObjectui64v)                                                       \
+  X(GetShaderInfoLog)                                                          \
+  X(GetShaderiv)                                                               \
+  X(GetUniformBlockIndex)                                                      \
+  X(GetUniformIndices)                                                         \
+  X(GetUniformLocation)                                                        \
+  X(LinkProgram)                                                               \
+  X(NamedBufferData)                                                           \
+  X(NamedBufferSubData)                                                        \
+  X(NamedFramebufferRenderbuffer)                                              \
+  X(NamedFramebufferTexture)                                                   \
+  X(NamedRenderbufferStorage)                                                  \
+  X(PixelStorei)                                                               \
+  X(ProgramUniform1fv)                                                         \
+  X(ProgramUniform1iv)                                                         \
+  X(ProgramUniform1uiv)                                                        \
+  X(ProgramUniform2fv)                                                         \
+  X(ProgramUniform3fv)                                                         \
+  X(ProgramUniform4fv)                                                         \
+  X(ProgramUniformMatrix3fv)                                                   \
+  X(ProgramUniformMatrix4fv)                                                   \
+  X(QueryCounter)                                                              \
+  X(RenderbufferStorage)                                                       \
+  X(SamplerParameteri)                                                         \
+  X(ShaderSource)                                                              \
+  X(ShaderStorageBlockBinding)                                                 \
+  X(TexImage2D)                                                                \
+  X(TexImage3D)                                                                \
+  X(TexParameterf)                                                             \
+  X(TexParameteri)                                                             \
+  X(TexParameteriv)                                                            \
+  X(TexSubImage3D)                                                             \
+  X(TextureParameterf)                                                         \
+  X(TextureParameteri)                                                         \
+  X(TextureParameteriv)                                                        \
+  X(TextureStorage2D)                                                          \
+  X(TextureStorage3D)                                                          \
+  X(TextureSubImage2D)                                                         \
+  X(TextureSubImage3D)                                                         \
+  X(Uniform1f)                                                                 \
+  X(Uniform1i)                                                                 \
+  X(Uniform3f)                                                                 \
+  X(Uniform3fv)                                                                \
+  X(Uniform3i)                                                                 \
+  X(UniformBlockBinding)                                                       \
+  X(UniformMatrix4fv)                                                          \
+  X(UseProgram)                                                                \
+  X(VertexArrayAttribBinding)                                                  \
+  X(VertexArrayAttribFormat)                                                   \
+  X(VertexArrayBindingDivisor)                                                 \
+  X(VertexArrayElementBuffer)                                                  \
+  X(VertexArrayVertexBuffer)                                                   \
+  X(VertexAttribDivisor)                                                       \
+  X(VertexAttribPointer)                                                       \
+  X(Viewport)
+enum class gl_function : size_t {
+#define OPENGL_NULL_BACKEND_ENUM(name) name,
+  OPENGL_NULL_BACKEND_FUNCTIONS(OPENGL_NULL_BACKEND_ENUM)
+#undef OPENGL_NULL_BACKEND_ENUM
+  count
+};
+
+constexpr auto function_count = static_cast<size_t>(gl_function::count);
+
+constexpr std::array<std::string_view, function_count> function_names{
+#define OPENGL_NULL_BACKEND_NAME(name) "gl" #name,
+    OPENGL_NULL_BACKEND_FUNCTIONS(OPENGL_NULL_BACKEND_NAME)
+#undef OPENGL_NULL_BACKEND_NAME
+};
+
+template <gl_function f> struct function_slot;
+#define OPENGL_NULL_BACKEND_SLOT(name)                                         \
+  template <> struct function_slot<gl_function::name> {                        \
+    static constexpr auto slot = &glad_gl##name;                               \
+  };
+OPENGL_NULL_BACKEND_FUNCTIONS(OPENGL_NULL_BACKEND_SLOT)
+#undef OPENGL_NULL_BACKEND_SLOT
+
+template <gl_function f>
+using function_type = std::remove_pointer_t<decltype(function_slot<f>::slot)>;
+
+// the entry points install() replaced
+template <gl_function f> function_type<f> saved_function{};
+
+bool installed{false};
+std::array<size_t, function_count> call_counts{};
+GLuint next_name{1};
+std::unordered_map<std::string, GLint> uniform_locations;
+std::unordered_map<std::string, GLuint> resource_indices;
+
+// what the reflection of a program reports
+struct program_interface {
+  std::vector<null_backend::uniform_variable> uniforms;
+  // of each uniform, -1 outside blocks
+  std::vector<GLint> block_indices;
+  std::vector<std::string> blocks;
+  std::vector<GLint> block_sizes;
+  std::vector<std::vector<GLint>> block_members;
+};
+std::shared_ptr<const program_interface> next_interface{
+    std::make_shared<program_interface>()};
+std::unordered_map<GLuint, std::shared_ptr<const program_interface>>
+    program_interfaces;
+
+constexpr bool creates_names(gl_function f) noexcept {
+  switch (f) {
+  case gl_function::CreateBuffers:
+  case gl_function::CreateFramebuffers:
+  case gl_function::CreateRenderbuffers:
+  case gl_function::CreateSamplers:
+  case gl_function::CreateTextures:
+  case gl_function::CreateVertexArrays:
+  case gl_function::GenBuffers:
+  case gl_function::GenFramebuffers:
+  case gl_function::GenQueries:
+  case gl_function::GenRenderbuffers:
+  case gl_function::GenSamplers:
+  case gl_function::GenTextures:
+  case gl_function::GenVertexArrays:
+    return true;
+  default:
+    return false;
+  }
+}
+
+// zero what an output argument points to, so that queries answer 0
+template <typename T> void clear_output(T argument) noexcept {
+  if constexpr (std::is_pointer_v<T>) {
+    using pointee = std::remove_pointer_t<T>;
+    if constexpr (!std::is_const_v<pointee> && std::is_arithmetic_v<pointee>) {
+      if (argument != nullptr) {
+        *argument = 0;
+      }
+    }
+  }
+}
+
+const program_interface &get_interface(GLuint program) {
+  static const program_interface empty_interface;
+  auto it = program_interfaces.find(program);
+  return it == program_interfaces.end() ? empty_interface : *it->second;
+}
+
+// bytes a uniform of the type takes in a std140 block
+constexpr GLint type_size(GLenum type) noexcept {
+  switch (type) {
+  case GL_FLOAT_VEC2:
+  case GL_INT_VEC2:
+  case GL_UNSIGNED_INT_VEC2:
+  case GL_BOOL_VEC2:
+    return 8;
+  case GL_FLOAT_VEC3:
+  case GL_INT_VEC3:
+  case GL_UNSIGNED_INT_VEC3:
+  case GL_BOOL_VEC3:
+    return 12;
+  case GL_FLOAT_VEC4:
+  case GL_INT_VEC4:
+  case GL_UNSIGNED_INT_VEC4:
+  case GL_BOOL_VEC4:
+    return 16;
+  case GL_FLOAT_MAT2:
+    return 32;
+  case GL_FLOAT_MAT3:
+    return 48;
+  case GL_FLOAT_MAT4:
+    return 64;
+  default:
+    return 4;
+  }
+}
+
+GLint uniform_property(const program_interface &reflection, GLuint index,
+                       GLenum pname) noexcept {
+  if (index >= reflection.uniforms.size()) {
+    return 0;
+  }
+  auto const &uniform = reflection.uniforms[index];
+  switch (pname) {
+  case GL_UNIFORM_TYPE:
+    return static_cast<GLint>(uniform.type);
+  case GL_UNIFORM_SIZE:
+    return uniform.size;
+  case GL_UNIFORM_BLOCK_INDEX:
+    return reflection.block_indices[index];
+  case GL_UNIFORM_OFFSET:
+    return uniform.offset;
+  case GL_UNIFORM_ARRAY_STRIDE:
+    return uniform.array_stride;
+  default:
+    return 0;
+  }
+}
+
+void copy_name(const std::string &source, GLsizei buffer_size,
+               GLsizei *length, GLchar *name) noexcept {
+  if (name == nullptr || buffer_size <= 0) {
+    return;
+  }
+  auto const size =
+      std::min(source.size(), static_cast<size_t>(buffer_size) - 1);
+  std::memcpy(name, source.data(), size);
+  name[size] = '\0';
+  if (length != nullptr) {
+    *length = static_cast<GLsizei>(size);
+  }
+}
+
+GLuint resource_index(const GLchar *name) {
+  return resource_indices
+      .try_emplace(name, static_cast<GLuint>(resource_indices.size()))
+      .first->second;
+}
+
+template <gl_function f, typename R, typename... A> R respond(A... args) {
+  [[maybe_unused]] std::tuple<A...> const arguments{args...};
+  if constexpr (creates_names(f)) {
+    // the names are the last argument and their count the one before
+    auto const count = std::get<sizeof...(A) - 2>(arguments);
+    auto const names = std::get<sizeof...(A) - 1>(arguments);
+    for (GLsizei i = 0; i < count; i++) {
+      names[i] = next_name++;
+    }
+  } else if constexpr (f == gl_function::CreateProgram) {
+    auto const program = next_name++;
+    program_interfaces[program] = next_interface;
+    return program;
+  } else if constexpr (f == gl_function::CreateShader) {
+    return next_name++;
+  } else if constexpr (f == gl_function::DeleteProgram) {
+    program_interfaces.erase(std::get<0>(arguments));
+  } else if constexpr (f == gl_function::GetProgramiv ||
+                       f == gl_function::GetShaderiv) {
+    auto const pname = std::get<1>(arguments);
+    auto const params = std::get<2>(arguments);
+    if (pname == GL_COMPILE_STATUS || pname == GL_LINK_STATUS) {
+      *params = GL_TRUE;
+    } else if (pname == GL_ACTIVE_UNIFORMS) {
+      auto const &reflection = get_interface(std::get<0>(arguments));
+      *params = static_cast<GLint>(reflection.uniforms.size());
+    } else if (pname == GL_ACTIVE_UNIFORM_BLOCKS) {
+      auto const &reflection = get_interface(std::get<0>(arguments));
+      *params = static_cast<GLint>(reflection.blocks.size());
+    }
+  } else if constexpr (f == gl_function::GetActiveUniform) {
+    auto const &reflection = get_interface(std::get<0>(arguments));
+    auto const index = std::get<1>(arguments);
+    if (index < reflection.uniforms.size()) {
+      auto const &uniform = reflection.uniforms[index];
+      if (auto size = std::get<4>(arguments); size != nullptr) {
+        *size = uniform.size;
+      }
+      if (auto type = std::get<5>(arguments); type != nullptr) {
+        *type = uniform.type;
+      }
+      copy_name(uniform.name, std::get<2>(arguments), std::get<3>(arguments),
+                std::get<6>(arguments));
+    }
+  } else if constexpr (f == gl_function::GetActiveUniformName) {
+    auto const &reflection = get_interface(std::get<0>(arguments));
+    auto const index = std::get<1>(arguments);
+    if (index < reflection.uniforms.size()) {
+      copy_name(reflection.uniforms[index].name, std::get<2>(arguments),
+                std::get<3>(arguments), std::get<4>(arguments));
+    }
+  } else if constexpr (f == gl_function::GetActiveUniformsiv) {
+    auto const &reflection = get_interface(std::get<0>(arguments));
+    auto const indices = std::get<2>(arguments);
+    auto const params = std::get<4>(arguments);
+    for (GLsizei i = 0; i < std::get<1>(arguments); i++) {
+      params[i] =
+          uniform_property(reflection, indices[i], std::get<3>(arguments));
+    }
+  } else if constexpr (f == gl_function::GetUniformIndices) {
+    auto const &reflection = get_interface(std::get<0>(arguments));
+    auto const names = std::get<2>(arguments);
+    auto const indices = std::get<3>(arguments);
+    for (GLsizei i = 0; i < std::get<1>(arguments); i++) {
+      auto it = std::find_if(
+          reflection.uniforms.begin(), reflection.uniforms.end(),
+          [name = names[i]](auto const &uniform) {
+            return uniform.name == name;
+          });
+      indices[i] = it == reflection.uniforms.end()
+                       ? GL_INVALID_INDEX
+                       : static_cast<GLuint>(it - reflection.uniforms.begin());
+    }
+  } else if constexpr (f == gl_function::GetActiveUniformBlockName) {
+    auto const &reflection = get_interface(std::get<0>(arguments));
+    auto const index = std::get<1>(arguments);
+    if (index < reflection.blocks.size()) {
+      copy_name(reflection.blocks[index], std::get<2>(arguments),
+                std::get<3>(arguments), std::get<4>(arguments));
+    }
+  } else if constexpr (f == gl_function::GetActiveUniformBlockiv) {
+    auto const &reflection = get_interface(std::get<0>(arguments));
+    auto const index = std::get<1>(arguments);
+    auto const params = std::get<3>(arguments);
+    if (index < reflection.blocks.size()) {
+      auto const &members = reflection.block_members[index];
+      switch (std::get<2>(arguments)) {
+      case GL_UNIFORM_BLOCK_DATA_SIZE:
+        *params = reflection.block_sizes[index];
+        break;
+      case GL_UNIFORM_BLOCK_ACTIVE_UNIFORMS:
+        *params = static_cast<GLint>(members.size());
+        break;
+      case GL_UNIFORM_BLOCK_ACTIVE_UNIFORM_INDICES:
+        std::copy(members.begin(), members.end(), params);
+        break;
+      }
+    }
+  } else if constexpr (f == gl_function::GetIntegerv) {
+    if (std::get<0>(arguments) == GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT) {
+      *std::get<1>(arguments) = 256;
+    }
+  } else if constexpr (f == gl_function::GetQueryObjectiv) {
+    if (std::get<1>(arguments) == GL_QUERY_RESULT_AVAILABLE) {
+      *std::get<2>(arguments) = GL_TRUE;
+    }
+  } else if constexpr (f == gl_function::CheckFramebufferStatus ||
+                       f == gl_function::CheckNamedFramebufferStatus) {
+    return GL_FRAMEBUFFER_COMPLETE;
+  } else if constexpr (f == gl_function::GetUniformLocation) {
+    // members of blocks have no location
+    auto const &uniforms = get_interface(std::get<0>(arguments)).uniforms;
+    auto const name = std::get<1>(arguments);
+    if (std::any_of(uniforms.begin(), uniforms.end(),
+                    [name](auto const &uniform) {
+                      return !uniform.block.empty() && uniform.name == name;
+                    })) {
+      return -1;
+    }
+    return uniform_locations
+        .try_emplace(name, static_cast<GLint>(uniform_locations.size()))
+        .first->second;
+  } else if constexpr (f == gl_function::GetUniformBlockIndex) {
+    auto const &blocks = get_interface(std::get<0>(arguments)).blocks;
+    auto it = std::find(blocks.begin(), blocks.end(), std::get<1>(arguments));
+    return it == blocks.end() ? GL_INVALID_INDEX
+                              : static_cast<GLuint>(it - blocks.begin());
+  } else if constexpr (f == gl_function::GetProgramResourceIndex) {
+    return resource_index(std::get<2>(arguments));
+  }
+  if constexpr (!std::is_void_v<R>) {
+    return R{};
+  }
+}
+
+template <gl_function f, typename F> struct null_function;
+
+template <gl_function f, typename R, typename... A>
+struct null_function<f, R(APIENTRYP)(A...)> {
+  static R APIENTRY call(A... args) {
+    call_counts[static_cast<size_t>(f)]++;
+    (clear_output(args), ...);
+    return respond<f, R>(args...);
+  }
+};
+} // namespace
+
+void null_backend::install() {
+  if (installed) {
+    return;
+  }
+#define OPENGL_NULL_BACKEND_INSTALL(name)                                      \
+  saved_function<gl_function::name> = glad_gl##name;                           \
+  glad_gl##name = &null_function<gl_function::name,                            \
+                                 function_type<gl_function::name>>::call;
+  OPENGL_NULL_BACKEND_FUNCTIONS(OPENGL_NULL_BACKEND_INSTALL)
+#undef OPENGL_NULL_BACKEND_INSTALL
+  next_name = 1;
+  uniform_locations.clear();
+  resource_indices.clear();
+  program_interfaces.clear();
+  reset_call_counts();
+  installed = true;
+}
+
+void null_backend::uninstall() {
+  if (!installed) {
+    return;
+  }
+#define OPENGL_NULL_BACKEND_UNINSTALL(name)                                    \
+  glad_gl##name = saved_function<gl_function::name>;
+  OPENGL_NULL_BACKEND_FUNCTIONS(OPENGL_NULL_BACKEND_UNINSTALL)
+#undef OPENGL_NULL_BACKEND_UNINSTALL
+  installed = false;
+}
+
+bool null_backend::is_installed() noexcept { return installed; }
+
+size_t null_backend::get_call_count(std::string_view function) noexcept {
+  for (size_t i = 0; i < function_count; i++) {
+    if (function_names[i] == function) {
+      return call_counts[i];
+    }
+  }
+  return 0;
+}
+
+size_t null_backend::get_total_call_count() noexcept {
+  return std::accumulate(call_counts.begin(), call_counts.end(), size_t(0));
+}
+
+std::map<std::string_view, size_t> null_backend::get_call_counts() {
+  std::map<std::string_view, size_t> counts;
+  for (size_t i = 0; i < function_count; i++) {
+    if (call_counts[i] != 0) {
+      counts.emplace(function_names[i], call_counts[i]);
+    }
+  }
+  return counts;
+}
+
+void null_backend::reset_call_counts() noexcept { call_counts.fill(0); }
+
+void null_backend::set_program_interface(
+    std::vector<uniform_variable> uniforms) {
+  auto reflection = std::make_shared<program_interface>();
+  for (size_t i = 0; i < uniforms.size(); i++) {
+    auto const &uniform = uniforms[i];
+    if (uniform.block.empty()) {
+      reflection->block_indices.push_back(-1);
+      continue;
+    }
+    auto &blocks = reflection->blocks;
+    auto const block_index = static_cast<size_t>(
+        std::find(blocks.begin(), blocks.end(), uniform.block) -
+        blocks.begin());
+    if (block_index == blocks.size()) {
+      blocks.push_back(uniform.block);
+      reflection->block_sizes.push_back(0);
+      reflection->block_members.emplace_back();
+    }
+    reflection->block_indices.push_back(static_cast<GLint>(block_index));
+    reflection->block_members[block_index].push_back(static_cast<GLint>(i));
+    // std140 blocks are padded to a multiple of a vec4
+    auto const end = uniform.offset +
+                     (uniform.size - 1) * uniform.array_stride +
+                     type_size(uniform.type);
+    auto &block_size = reflection->block_sizes[block_index];
+    block_size = std::max(block_size, (end + 15) / 16 * 16);
+  }
+  reflection->uniforms = std::move(uniforms);
+  next_interface = std::move(reflection);
+}
+
+} // namespace opengl
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "context.hpp"
+
+namespace opengl {
+
+// A GL backend that does no work.
+//
+// The wrappers call GL through the entry points glad loads. install() points
+// every entry point the library uses at a function that counts the call and
+// returns at once. Objects get fresh names, compiles, links and framebuffer
+// checks succeed, queries report their results as available, and the other
+// queries answer zero. Programs show the interface declared with
+// set_program_interface() when they were created, an empty one by default.
+// Uniform locations and storage block indices are handed out per name. No
+// context or GPU is needed, which makes the CPU cost of the library itself
+// measurable. Use it on one thread only.
+class null_backend final {
+
+public:
+  // call instead of context::create
+  static void install();
+  // put back the entry points install() replaced
+  static void uninstall();
+  static bool is_installed() noexcept;
+
+  // calls made since install() or reset_call_counts(), e.g. of
+  // "glDrawElements"
+  static size_t get_call_count(std::string_view function) noexcept;
+  static size_t get_total_call_count() noexcept;
+  // the functions called at least once
+  static std::map<std::string_view, size_t> get_call_counts();
+  static void reset_call_counts() noexcept;
+
+  // an active uniform as the program reflection reports it
+  struct uniform_variable {
+    std::string name;
+    GLenum type{};
+    GLint size{1};
+    // the uniform block holding it, empty for a plain uniform
+    std::string block;
+    GLint offset{-1};
+    GLint array_stride{};
+  };
+
+  // the active uniforms of the programs created from now on; their blocks
+  // follow from the members and are sized to hold them
+  static void set_program_interface(std::vector<uniform_variable> uniforms);
+};
+
+} // namespace opengl
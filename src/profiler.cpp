@@ -0,0 +1,213 @@
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <numeric>
+#include <string_view>
+
+#include "error.hpp"
+#include "profiler.hpp"
+
+namespace opengl {
+
+uint64_t profiler::begin_zone(const char *name) {
+  auto const query = acquire_query();
+  if (query == 0) {
+    return no_zone;
+  }
+  if (!clock_offset) {
+    GLint64 gpu_now = 0;
+    glGetInteger64v(GL_TIMESTAMP, &gpu_now);
+    clock_offset = cpu_now() - gpu_now;
+  }
+  glQueryCounter(query, GL_TIMESTAMP);
+  auto const id = next_zone_id++;
+  open_zones.push_back({id, name, cpu_now(), query});
+  return id;
+}
+
+void profiler::end_zone(uint64_t id) {
+  auto it = std::find_if(open_zones.rbegin(), open_zones.rend(),
+                         [id](auto const &zone) { return zone.id == id; });
+  if (it == open_zones.rend()) {
+    // dropped when an enclosing zone ended first
+    return;
+  }
+  if (it != open_zones.rbegin()) {
+    std::cerr << "profiler zones are not nested" << std::endl;
+    // the zones opened inside this one are dropped unmeasured
+    for (auto inner = open_zones.rbegin(); inner != it; ++inner) {
+      free_queries.push_back(inner->begin_query);
+    }
+  }
+  auto const zone = *it;
+  open_zones.erase(std::prev(it.base()), open_zones.end());
+
+  auto const query = acquire_query();
+  if (query != 0) {
+    glQueryCounter(query, GL_TIMESTAMP);
+  }
+  auto const cpu_end = cpu_now();
+
+  if (query != 0) {
+    pending_zones.push_back(
+        {zone.name, records_dropped + records.size(), zone.begin_query, query});
+  } else {
+    free_queries.push_back(zone.begin_query);
+  }
+  records.push_back({zone.name, current_frame, zone.cpu_begin, cpu_end, 0, 0});
+  add_sample(get_samples(zone.name).cpu_milliseconds,
+             static_cast<double>(cpu_end - zone.cpu_begin) / 1e6);
+  trim_trace();
+}
+
+void profiler::end_frame() {
+  current_frame++;
+  // queries complete in order, so stop at the first one still in flight
+  while (!pending_zones.empty()) {
+    auto const &zone = pending_zones.front();
+    GLint available = 0;
+    glGetQueryObjectiv(zone.end_query, GL_QUERY_RESULT_AVAILABLE, &available);
+    if (check_error()) {
+      std::cerr << "glGetQueryObjectiv failed" << std::endl;
+      return;
+    }
+    if (!available) {
+      break;
+    }
+    GLuint64 gpu_begin = 0, gpu_end = 0;
+    glGetQueryObjectui64v(zone.begin_query, GL_QUERY_RESULT, &gpu_begin);
+    glGetQueryObjectui64v(zone.end_query, GL_QUERY_RESULT, &gpu_end);
+    if (zone.record_index >= records_dropped) {
+      auto &r = records[zone.record_index - records_dropped];
+      r.gpu_begin = gpu_begin;
+      r.gpu_end = gpu_end;
+    }
+    add_sample(get_samples(zone.name).gpu_milliseconds,
+               static_cast<double>(gpu_end - gpu_begin) / 1e6);
+    free_queries.push_back(zone.begin_query);
+    free_queries.push_back(zone.end_query);
+    pending_zones.pop_front();
+  }
+}
+
+std::map<std::string, profiler::zone_statistics>
+profiler::get_statistics() const {
+  std::map<std::string, zone_statistics> result;
+  auto average = [](const std::deque<double> &window) {
+    return window.empty() ? 0.0
+                          : std::accumulate(window.begin(), window.end(), 0.0) /
+                                static_cast<double>(window.size());
+  };
+  for (auto const &[name, s] : zone_samples) {
+    auto &statistics = result[name];
+    statistics.cpu_milliseconds = average(s.cpu_milliseconds);
+    statistics.gpu_milliseconds = average(s.gpu_milliseconds);
+    statistics.samples = s.cpu_milliseconds.size();
+  }
+  return result;
+}
+
+bool profiler::write_chrome_trace(
+    const std::filesystem::path &trace_file) const {
+  std::ofstream out(trace_file);
+  if (!out) {
+    std::cerr << "open " << trace_file << " failed" << std::endl;
+    return false;
+  }
+
+  // timestamps in microseconds; names are expected to need no escaping
+  out << "{\"traceEvents\":[\n";
+  bool first = true;
+  auto event = [&](const char *name, int tid, int64_t begin, int64_t end,
+                   uint64_t frame) {
+    out << (first ? "" : ",\n") << "{\"name\":\"" << name
+        << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << tid
+        << ",\"ts\":" << static_cast<double>(begin) / 1e3
+        << ",\"dur\":" << static_cast<double>(end - begin) / 1e3
+        << ",\"args\":{\"frame\":" << frame << "}}";
+    first = false;
+  };
+  for (auto const &r : records) {
+    event(r.name, 1, r.cpu_begin, r.cpu_end, r.frame);
+    if (r.gpu_end != 0 && clock_offset) {
+      event(r.name, 2, static_cast<int64_t>(r.gpu_begin) + *clock_offset,
+            static_cast<int64_t>(r.gpu_end) + *clock_offset, r.frame);
+    }
+  }
+  out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+  if (!out) {
+    std::cerr << "write " << trace_file << " failed" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+void profiler::clear() {
+  for (auto const &zone : open_zones) {
+    free_queries.push_back(zone.begin_query);
+  }
+  for (auto const &zone : pending_zones) {
+    free_queries.push_back(zone.begin_query);
+    free_queries.push_back(zone.end_query);
+  }
+  if (!free_queries.empty()) {
+    glDeleteQueries(static_cast<GLsizei>(free_queries.size()),
+                    free_queries.data());
+  }
+  free_queries.clear();
+  open_zones.clear();
+  pending_zones.clear();
+  records.clear();
+  records_dropped = 0;
+  zone_samples.clear();
+  clock_offset.reset();
+}
+
+GLuint profiler::acquire_query() {
+  if (free_queries.empty()) {
+    // grow the ring in batches
+    free_queries.resize(64);
+    glGenQueries(static_cast<GLsizei>(free_queries.size()),
+                 free_queries.data());
+    if (check_error()) {
+      std::cerr << "glGenQueries failed" << std::endl;
+      free_queries.clear();
+      return 0;
+    }
+  }
+  auto const query = free_queries.back();
+  free_queries.pop_back();
+  return query;
+}
+
+int64_t profiler::cpu_now() noexcept {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+void profiler::add_sample(std::deque<double> &window, double value) {
+  window.push_back(value);
+  while (window.size() > sample_window) {
+    window.pop_front();
+  }
+}
+
+profiler::samples &profiler::get_samples(const char *name) {
+  auto it = zone_samples.find(std::string_view(name));
+  if (it == zone_samples.end()) {
+    it = zone_samples.emplace(name, samples{}).first;
+  }
+  return it->second;
+}
+
+void profiler::trim_trace() {
+  while (records.size() > trace_capacity) {
+    records.pop_front();
+    records_dropped++;
+  }
+}
+
+} // namespace opengl
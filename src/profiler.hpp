@@ -0,0 +1,164 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <iostream>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "context.hpp"
+
+namespace opengl {
+
+// CPU and GPU timing of named zones.
+//
+// A zone measures the CPU time between its construction and destruction and
+// the GPU time between GL_TIMESTAMP queries issued at both points, so zones
+// nest. Query results are collected by end_frame() once the GPU has produced
+// them, and the query objects are then reused, so reading them never stalls.
+// Zones cost a flag test while the profiler is disabled. Use it on the GL
+// thread only.
+class profiler final {
+
+public:
+  struct zone_statistics {
+    // averages over the last sample_window samples
+    double cpu_milliseconds{};
+    double gpu_milliseconds{};
+    size_t samples{};
+  };
+
+  class zone final {
+  public:
+    // name has to outlive the profiler's records, e.g. a string literal
+    explicit zone(const char *name) {
+      if (instance().enabled) {
+        id = instance().begin_zone(name);
+      }
+    }
+
+    zone(const zone &) = delete;
+    zone &operator=(const zone &) = delete;
+
+    zone(zone &&) noexcept = delete;
+    zone &operator=(zone &&) noexcept = delete;
+
+    ~zone() noexcept {
+      if (id == no_zone) {
+        return;
+      }
+      try {
+        instance().end_zone(id);
+      } catch (const std::exception &e) {
+        // recording may allocate; the zone is lost then
+        std::cerr << "profiler zone failed:" << e.what() << std::endl;
+      }
+    }
+
+  private:
+    uint64_t id{no_zone};
+  };
+
+public:
+  static profiler &instance() {
+    static profiler p;
+    return p;
+  }
+
+  profiler(const profiler &) = delete;
+  profiler &operator=(const profiler &) = delete;
+
+  profiler(profiler &&) noexcept = delete;
+  profiler &operator=(profiler &&) noexcept = delete;
+
+  void set_enabled(bool enabled_) noexcept { enabled = enabled_; }
+  bool is_enabled() const noexcept { return enabled; }
+
+  // number of samples per zone the averages are taken over
+  void set_sample_window(size_t samples) noexcept { sample_window = samples; }
+
+  // number of zones kept for the trace, oldest dropped first
+  void set_trace_capacity(size_t zones) noexcept { trace_capacity = zones; }
+
+  // call once per frame with a current context
+  void end_frame();
+
+  std::map<std::string, zone_statistics> get_statistics() const;
+
+  // write the recorded zones in the Chrome trace event format, CPU zones on
+  // one thread and GPU zones on another
+  bool write_chrome_trace(const std::filesystem::path &trace_file) const;
+
+  // drop every record and query; call before the context is destroyed
+  void clear();
+
+private:
+  profiler() = default;
+  ~profiler() noexcept = default;
+
+  static constexpr uint64_t no_zone = 0;
+
+  struct record {
+    const char *name;
+    uint64_t frame;
+    // nanoseconds on the CPU clock
+    int64_t cpu_begin;
+    int64_t cpu_end;
+    // nanoseconds on the GPU clock; gpu_end is 0 until resolved
+    uint64_t gpu_begin;
+    uint64_t gpu_end;
+  };
+
+  struct open_zone {
+    uint64_t id;
+    const char *name;
+    int64_t cpu_begin;
+    GLuint begin_query;
+  };
+
+  struct pending_zone {
+    const char *name;
+    // counted from the first record ever made
+    size_t record_index;
+    GLuint begin_query;
+    GLuint end_query;
+  };
+
+  struct samples {
+    std::deque<double> cpu_milliseconds;
+    std::deque<double> gpu_milliseconds;
+  };
+
+  // the id of the opened zone, no_zone if none could be opened
+  uint64_t begin_zone(const char *name);
+  void end_zone(uint64_t id);
+  // 0 if no query object could be created
+  GLuint acquire_query();
+  static int64_t cpu_now() noexcept;
+  void add_sample(std::deque<double> &window, double value);
+  samples &get_samples(const char *name);
+  void trim_trace();
+
+private:
+  bool enabled{false};
+  size_t sample_window{64};
+  size_t trace_capacity{1 << 16};
+  uint64_t current_frame{};
+  // CPU minus GPU clock, measured when the first query is issued
+  std::optional<int64_t> clock_offset;
+  std::vector<GLuint> free_queries;
+  std::vector<open_zone> open_zones;
+  uint64_t next_zone_id{1};
+  std::deque<pending_zone> pending_zones;
+  // finished zones in order of completion; records_dropped counts the ones
+  // trimmed from the front
+  std::deque<record> records;
+  size_t records_dropped{};
+  std::map<std::string, samples, std::less<>> zone_samples;
+};
+
+} // namespace opengl
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <filesystem>
 #include <fstream>
 #include <functional>
@@ -9,10 +10,20 @@
 #include <set>
 #include <sstream>
 #include <stdexcept>
+#include <string>
+#include <string_view>
 #include <tuple>
+#include <variant>
+#include <vector>
 
 #include "error.hpp"
+#include "render_statistics.hpp"
+#include "sampler.hpp"
+#include "shader_storage_buffer.hpp"
 #include "texture.hpp"
+#include "texture_cache.hpp"
+#include "uniform.hpp"
+#include "uniform_arena.hpp"
 #include "uniform_buffer.hpp"
 #include "vertex_array.hpp"
 
@@ -25,6 +36,7 @@ public:
     if (*program_id == 0) {
       throw_exception("glCreateProgram failed");
     }
+    render_statistics::get_current().objects_created++;
   }
 
   program(const program &) = delete;
@@ -68,6 +80,9 @@ public:
           if (program_id) {
             glDetachShader(*program_id, *ptr);
           }
+          if (*ptr != 0) {
+            render_statistics::get_current().objects_deleted++;
+          }
           glDeleteShader(*ptr);
           delete ptr;
         });
@@ -77,12 +92,14 @@ public:
       std::cerr << "glCreateShader failed" << std::endl;
       return false;
     }
+    render_statistics::get_current().objects_created++;
 
     const auto source_data = source_code.data();
     GLint source_size = source_code.size();
 
     glShaderSource(*shader_id, 1, &source_data, &source_size);
     glCompileShader(*shader_id);
+    render_statistics::get_current().shader_compiles++;
 
     GLint success = 0;
     glGetShaderiv(*shader_id, GL_COMPILE_STATUS, &success);
@@ -103,13 +120,93 @@ public:
     shaders[shader_type].emplace_back(std::move(shader_id));
     assigned_uniform_variables.clear();
     clear_textures();
+    arena_blocks.clear();
+    storage_blocks.clear();
     linked = false;
     return true;
   }
 
-  void clear_textures() { assigned_textures.clear(); }
+  // keeps the map nodes, so that assigning the same variables again does not
+  // allocate
+  void clear_textures() noexcept {
+    for (auto &[_, texture] : assigned_textures) {
+      texture = std::monostate{};
+    }
+  }
+
+  // sample the texture assigned to variable_name through sampler_object
+  // instead of the texture's own parameters
+  void set_sampler(const std::string &variable_name,
+                   opengl::sampler sampler_object) {
+    assigned_samplers.insert_or_assign(variable_name,
+                                       std::move(sampler_object));
+  }
+
+  // The texture and sampler of every texture unit, resolved once against this
+  // program so that binding them needs no lookup by name. Units without a
+  // texture hold 0.
+  struct texture_set {
+    // refreshed from cached_textures when texture_cache reloads a texture
+    mutable std::vector<GLuint> texture_ids;
+    std::vector<GLenum> targets;
+    std::vector<GLuint> sampler_ids;
+
+    // the textures of texture_cache in the set, which binding reports as
+    // drawn and reloads after an eviction
+    struct cached_texture {
+      size_t unit;
+      std::shared_ptr<GLuint> texture_id;
+      std::shared_ptr<texture_residency> residency;
+    };
+    std::vector<cached_texture> cached_textures;
+  };
+
+  // record texture in textures at the unit of variable_name, together with
+  // the sampler set for that variable; the variable counts as assigned from
+  // then on
+  bool add_to_texture_set(texture_set &textures,
+                          std::string_view variable_name,
+                          const ::opengl::texture &texture) {
+    if (!link()) {
+      return false;
+    }
+    auto it = texture_units.find(variable_name);
+    if (it == texture_units.end()) {
+      std::cerr << "no sampler uniform " << variable_name << std::endl;
+      return false;
+    }
+    auto const unit_count = texture_units.size();
+    textures.texture_ids.resize(unit_count, 0);
+    textures.targets.resize(unit_count, 0);
+    textures.sampler_ids.resize(unit_count, 0);
+
+    auto const unit = it->second;
+    textures.texture_ids[unit] = *texture.texture_id;
+    textures.targets[unit] = texture.target;
+    auto &cached = textures.cached_textures;
+    cached.erase(
+        std::remove_if(cached.begin(), cached.end(),
+                       [unit](auto const &c) { return c.unit == unit; }),
+        cached.end());
+    if (texture.residency) {
+      cached.push_back({unit, texture.texture_id, texture.residency});
+    }
+    if (auto sampler_it = assigned_samplers.find(variable_name);
+        sampler_it != assigned_samplers.end()) {
+      textures.sampler_ids[unit] = sampler_it->second.get_id();
+    }
+    assigned_uniform_variables.emplace(it->first);
+    return true;
+  }
 
-  bool use() noexcept {
+  bool use() noexcept { return use(nullptr); }
+
+  // use the program with a prepared texture set in place of the textures
+  // assigned by name
+  bool use(const texture_set &textures) noexcept { return use(&textures); }
+
+private:
+  bool use(const texture_set *textures) noexcept {
     if (!install()) {
       return false;
     }
@@ -119,41 +216,50 @@ public:
       }
     }
 
-    GLenum next_texture_unit{GL_TEXTURE0};
-    for (auto &[variable_name, texture] : assigned_textures) {
-      if (!texture->use(next_texture_unit)) {
+    if (textures) {
+      if (!bind_texture_set(*textures)) {
         return false;
       }
-
-      if (!set_uniform_by_callback(
-              variable_name, [next_texture_unit](auto location) {
-                glUniform1i(location, next_texture_unit - GL_TEXTURE0);
-              })) {
-        return false;
-      }
-
-      next_texture_unit++;
-    }
-
-    auto block_names_opt = get_uniform_block_names();
-    if (!block_names_opt) {
+    } else if (!bind_textures()) {
       return false;
     }
-    for (auto const &block_name : block_names_opt.value()) {
-      if (uniform_blocks.count(block_name)) {
+
+    for (auto const &block_name : uniform_block_names) {
+      if (uniform_blocks.count(block_name) || arena_blocks.count(block_name)) {
         continue;
       }
       auto it = cross_program_uniform_blocks.find(block_name);
-      if (it == cross_program_uniform_blocks.end()) {
+      if (it == cross_program_uniform_blocks.end() || it->second.expired()) {
         std::cerr << "uniform block\"" << block_name << "\" is not assigned"
                   << std::endl;
         return false;
       }
-      uniform_blocks.insert(*it);
+      // shares the block after checking its layout
+      if (!get_uniform_block(block_name)) {
+        return false;
+      }
+    }
+
+    for (auto const &block_name : storage_block_names) {
+      auto it = storage_blocks.find(block_name);
+      if (it == storage_blocks.end()) {
+        std::cerr << "shader storage block \"" << block_name
+                  << "\" is not assigned" << std::endl;
+        return false;
+      }
+      glBindBufferBase(GL_SHADER_STORAGE_BUFFER, it->second.binding_point,
+                       *it->second.storage->buffer_id);
+      if (check_error()) {
+        std::cerr << "glBindBufferBase failed" << std::endl;
+        return false;
+      }
     }
 
     GLuint binding_point = 0;
     for (const auto &[uniform_block_name, uniform_buffer] : uniform_blocks) {
+      if (arena_blocks.count(uniform_block_name)) {
+        continue;
+      }
       auto block_index =
           glGetUniformBlockIndex(*program_id, uniform_block_name.c_str());
       if (block_index == GL_INVALID_INDEX) {
@@ -172,6 +278,17 @@ public:
       }
       binding_point++;
     }
+    for (const auto &[_, block] : arena_blocks) {
+      glUniformBlockBinding(*program_id, block.index, binding_point);
+      if (check_error()) {
+        std::cerr << "glUniformBlockBinding failed" << std::endl;
+        return false;
+      }
+      if (!block.arena->use(binding_point, block.block_range)) {
+        return false;
+      }
+      binding_point++;
+    }
 
 #ifndef NDEBUG
     if (!check_uniform_assignment()) {
@@ -181,28 +298,96 @@ public:
     return true;
   }
 
-  bool set_uniform_by_callback(
-      const std::string &variable_name,
-      std::function<void(GLint location)> set_function) noexcept {
+public:
+  template <typename callback_type>
+  bool set_uniform_by_callback(std::string_view variable_name,
+                               callback_type &&set_function) noexcept {
     if (!install()) {
       return false;
     }
-    auto location = glGetUniformLocation(*program_id, variable_name.c_str());
-    if (location == -1) {
-      std::cerr << "glGetUniformLocation failed:" << variable_name << std::endl;
-      return false;
+    auto it = uniform_locations.find(variable_name);
+    if (it == uniform_locations.end()) {
+      std::string name(variable_name);
+      auto location = glGetUniformLocation(*program_id, name.c_str());
+      if (location == -1) {
+        std::cerr << "glGetUniformLocation failed:" << variable_name
+                  << std::endl;
+        return false;
+      }
+      it = uniform_locations.emplace(std::move(name), location).first;
+      assigned_uniform_variables.emplace(it->first);
     }
-    set_function(location);
+    set_function(it->second);
+    forget_uniform_value(it->second);
     if (check_error()) {
       std::cerr << "set_function failed:" << variable_name << std::endl;
       return false;
     }
-    assigned_uniform_variables.insert(variable_name);
+    render_statistics::get_current().uniform_updates++;
     return true;
   }
 
+  // Resolve a uniform variable or array once for repeated uploads. The
+  // variable counts as assigned from then on. The handle is invalid if the
+  // program does not link or has no such variable of type T.
+  template <typename T>
+  ::opengl::uniform<T> get_uniform(std::string_view variable_name) noexcept {
+    if (!link()) {
+      return {};
+    }
+    std::string name(variable_name);
+    auto location = glGetUniformLocation(*program_id, name.c_str());
+    if (location == -1) {
+      std::cerr << "glGetUniformLocation failed:" << name << std::endl;
+      return {};
+    }
+
+    GLuint index = GL_INVALID_INDEX;
+    auto name_ptr = name.c_str();
+    glGetUniformIndices(*program_id, 1, &name_ptr, &index);
+    if (check_error() || index == GL_INVALID_INDEX) {
+      std::cerr << "glGetUniformIndices failed:" << name << std::endl;
+      return {};
+    }
+    GLint size = 0;
+    GLint type = 0;
+    glGetActiveUniformsiv(*program_id, 1, &index, GL_UNIFORM_SIZE, &size);
+    glGetActiveUniformsiv(*program_id, 1, &index, GL_UNIFORM_TYPE, &type);
+    if (check_error()) {
+      std::cerr << "glGetActiveUniformsiv failed:" << name << std::endl;
+      return {};
+    }
+    auto const gl_type = static_cast<GLenum>(type);
+    // the units of samplers are fixed at link time; bind_texture_set relies
+    // on them
+    if (is_sampler_type(gl_type)) {
+      std::cerr << "sampler uniforms are set by texture:" << name << std::endl;
+      return {};
+    }
+    if (gl_type != ::opengl::uniform<T>::gl_type() &&
+        !(std::is_same_v<T, GLint> && gl_type == GL_BOOL)) {
+      std::cerr << "uniform type mismatch:" << name << std::endl;
+      return {};
+    }
+
+    // arrays are reported as "name[0]"
+    if (auto bracket = name.find('['); bracket != std::string::npos) {
+      name.resize(bracket);
+    }
+    assigned_uniform_variables.emplace(size > 1 ? name + "[0]" : name);
+    // handles of the same variable share its cache
+    auto &cache = uniform_caches[location];
+    auto const cache_size = static_cast<size_t>(size) * sizeof(T);
+    if (cache.count != size || cache.last_values.size() != cache_size) {
+      cache.count = size;
+      cache.last_values.assign(cache_size, std::byte{});
+      cache.known_size = 0;
+    }
+    return ::opengl::uniform<T>(*program_id, location, size, cache);
+  }
+
   template <typename... value_types>
-  bool set_uniform(const std::string &variable_name,
+  bool set_uniform(std::string_view variable_name,
                    value_types &&... values) noexcept {
     static_assert(sizeof...(values) != 0, "no value specified");
     static_assert(sizeof...(values) == 1 || sizeof...(values) == 3,
@@ -220,6 +405,14 @@ public:
       auto &&value = std::get<0>(
           std::forward_as_tuple(std::forward<value_types>(values)...));
       if constexpr (std::is_same_v<real_value_type, GLint>) {
+        if (!link()) {
+          return false;
+        }
+        if (texture_units.find(variable_name) != texture_units.end()) {
+          std::cerr << "sampler uniforms are set by texture:" << variable_name
+                    << std::endl;
+          return false;
+        }
         return set_uniform_by_callback(variable_name, [value](auto location) {
           glUniform1i(location, value);
         });
@@ -229,12 +422,17 @@ public:
         });
       } else if constexpr (std::is_same_v<real_value_type,
                                           ::opengl::texture_2D> ||
+                           std::is_same_v<real_value_type,
+                                          ::opengl::texture_2D_array> ||
                            std::is_same_v<real_value_type,
                                           ::opengl::texture_cube_map>) {
-        std::unique_ptr<real_value_type> texture_ptr =
-            std::make_unique<real_value_type>(value);
-        assigned_textures.insert_or_assign(variable_name,
-                                           std::move(texture_ptr));
+        auto it = assigned_textures.find(variable_name);
+        if (it == assigned_textures.end()) {
+          it = assigned_textures
+                   .emplace(std::string(variable_name), std::monostate{})
+                   .first;
+        }
+        it->second = value;
         return true;
       } else if constexpr (std::is_same_v<real_value_type, glm::vec3>) {
         return set_uniform_by_callback(variable_name, [&value](auto location) {
@@ -290,21 +488,120 @@ public:
     if constexpr (sizeof...(values) == 1) {
       auto &&value = std::get<0>(
           std::forward_as_tuple(std::forward<value_types>(values)...));
-      if constexpr (std::is_same_v<real_value_type, glm::mat4>) {
-        return set_uniform_of_block_by_callback(
-            block_name, variable_name, [&value](auto &UBO, auto offset) {
-              return UBO.write(std::forward<decltype(value)>(value), offset);
-            });
+      if constexpr (is_std140_type_v<real_value_type>) {
+        auto UBO_ptr = get_uniform_block(block_name);
+        return UBO_ptr && UBO_ptr->write_member(variable_name, value);
       }
     }
     std::cerr << "unsupported value types" << std::endl;
     return false;
   }
 
+  // Bind storage to the shader storage block block_name whenever the program
+  // is used, until the next call for the block. storage has to outlive that.
+  template <typename data_type>
+  bool set_shader_storage_block(
+      const std::string &block_name,
+      const ::opengl::shader_storage_buffer<data_type> &storage) noexcept {
+    auto it = storage_blocks.find(block_name);
+    if (it == storage_blocks.end()) {
+      if (!link()) {
+        return false;
+      }
+      auto block_index = glGetProgramResourceIndex(
+          *program_id, GL_SHADER_STORAGE_BLOCK, block_name.c_str());
+      if (block_index == GL_INVALID_INDEX) {
+        std::cerr << "no shader storage block:" << block_name << std::endl;
+        return false;
+      }
+      // binding points are handed out once per block and program
+      auto const binding_point = static_cast<GLuint>(storage_blocks.size());
+      glShaderStorageBlockBinding(*program_id, block_index, binding_point);
+      if (check_error()) {
+        std::cerr << "glShaderStorageBlockBinding failed" << std::endl;
+        return false;
+      }
+      it = storage_blocks.emplace(block_name, storage_block{binding_point, {}})
+               .first;
+    }
+    it->second.storage = &storage;
+    return true;
+  }
+
+  // Source the block from a range of a uniform arena instead of a
+  // uniform_buffer, until the next call for the block. The range must cover
+  // the block's data size. The arena has to live until the program is next
+  // used.
+  bool
+  set_uniform_block_range(const std::string &block_name,
+                          ::opengl::uniform_arena &arena,
+                          const ::opengl::uniform_arena::range &r) noexcept {
+    auto it = arena_blocks.find(block_name);
+    if (it == arena_blocks.end()) {
+      if (!link()) {
+        return false;
+      }
+      auto block_index =
+          glGetUniformBlockIndex(*program_id, block_name.c_str());
+      if (block_index == GL_INVALID_INDEX) {
+        std::cerr << "glGetUniformBlockIndex failed" << std::endl;
+        return false;
+      }
+      GLint data_size = 0;
+      glGetActiveUniformBlockiv(*program_id, block_index,
+                                GL_UNIFORM_BLOCK_DATA_SIZE, &data_size);
+      if (check_error()) {
+        std::cerr << "glGetActiveUniformBlockiv failed" << std::endl;
+        return false;
+      }
+      it = arena_blocks
+               .emplace(block_name,
+                        arena_block{block_index, data_size, {}, {}})
+               .first;
+    }
+    // the shader would read past the range
+    if (r.size < it->second.data_size) {
+      std::cerr << "uniform arena range of " << r.size
+                << " bytes is smaller than uniform block \"" << block_name
+                << "\" of " << it->second.data_size << " bytes" << std::endl;
+      return false;
+    }
+    it->second.arena = &arena;
+    it->second.block_range = r;
+    return true;
+  }
+
+  // Write a struct mirroring the whole block with one copy. The struct layout
+  // comes from its uniform_block_layout specialization and is compared with
+  // the block once.
+  template <typename T>
+  bool set_uniform_block(const std::string &block_name,
+                         const T &data) noexcept {
+    constexpr auto const &layout = uniform_block_layout<T>::value;
+    static_assert(layout.is_valid(), "the struct does not follow std140");
+    auto UBO_ptr = get_uniform_block(block_name);
+    return UBO_ptr && UBO_ptr->write_block(data, layout);
+  }
+
 private:
+  // the uniform handles of the variable or array at location no longer know
+  // its value
+  void forget_uniform_value(GLint location) noexcept {
+    auto it = uniform_caches.upper_bound(location);
+    if (it == uniform_caches.begin()) {
+      return;
+    }
+    --it;
+    // the elements of an array are at consecutive locations
+    if (location - it->first < it->second.count) {
+      it->second.known_size = 0;
+    }
+  }
+
   bool link() {
     if (!linked) {
       glLinkProgram(*program_id);
+      render_statistics::get_current().program_links++;
 
       GLint success = 0;
       glGetProgramiv(*program_id, GL_LINK_STATUS, &success);
@@ -314,11 +611,211 @@ private:
         std::cerr << "glLinkProgram failed:" << infoLog << std::endl;
         return false;
       }
+      uniform_locations.clear();
+      // the caches stay allocated for the handles still pointing at them
+      for (auto &[_, cache] : uniform_caches) {
+        cache.known_size = 0;
+      }
+      if (!assign_texture_units()) {
+        return false;
+      }
+      auto block_names_opt = get_uniform_block_names();
+      if (!block_names_opt) {
+        return false;
+      }
+      uniform_block_names = std::move(block_names_opt.value());
+      auto storage_block_names_opt = get_storage_block_names();
+      if (!storage_block_names_opt) {
+        return false;
+      }
+      storage_block_names = std::move(storage_block_names_opt.value());
       linked = true;
     }
     return true;
   }
 
+  // the sampler types of the OpenGL 4.5 specification, table 7.3
+  static bool is_sampler_type(GLenum type) noexcept {
+    switch (type) {
+    case GL_SAMPLER_1D:
+    case GL_SAMPLER_2D:
+    case GL_SAMPLER_3D:
+    case GL_SAMPLER_CUBE:
+    case GL_SAMPLER_1D_SHADOW:
+    case GL_SAMPLER_2D_SHADOW:
+    case GL_SAMPLER_1D_ARRAY:
+    case GL_SAMPLER_2D_ARRAY:
+    case GL_SAMPLER_1D_ARRAY_SHADOW:
+    case GL_SAMPLER_2D_ARRAY_SHADOW:
+    case GL_SAMPLER_2D_MULTISAMPLE:
+    case GL_SAMPLER_2D_MULTISAMPLE_ARRAY:
+    case GL_SAMPLER_CUBE_SHADOW:
+    case GL_SAMPLER_BUFFER:
+    case GL_SAMPLER_2D_RECT:
+    case GL_SAMPLER_2D_RECT_SHADOW:
+    case GL_SAMPLER_CUBE_MAP_ARRAY:
+    case GL_SAMPLER_CUBE_MAP_ARRAY_SHADOW:
+    case GL_INT_SAMPLER_1D:
+    case GL_INT_SAMPLER_2D:
+    case GL_INT_SAMPLER_3D:
+    case GL_INT_SAMPLER_CUBE:
+    case GL_INT_SAMPLER_1D_ARRAY:
+    case GL_INT_SAMPLER_2D_ARRAY:
+    case GL_INT_SAMPLER_2D_MULTISAMPLE:
+    case GL_INT_SAMPLER_2D_MULTISAMPLE_ARRAY:
+    case GL_INT_SAMPLER_BUFFER:
+    case GL_INT_SAMPLER_2D_RECT:
+    case GL_INT_SAMPLER_CUBE_MAP_ARRAY:
+    case GL_UNSIGNED_INT_SAMPLER_1D:
+    case GL_UNSIGNED_INT_SAMPLER_2D:
+    case GL_UNSIGNED_INT_SAMPLER_3D:
+    case GL_UNSIGNED_INT_SAMPLER_CUBE:
+    case GL_UNSIGNED_INT_SAMPLER_1D_ARRAY:
+    case GL_UNSIGNED_INT_SAMPLER_2D_ARRAY:
+    case GL_UNSIGNED_INT_SAMPLER_2D_MULTISAMPLE:
+    case GL_UNSIGNED_INT_SAMPLER_2D_MULTISAMPLE_ARRAY:
+    case GL_UNSIGNED_INT_SAMPLER_BUFFER:
+    case GL_UNSIGNED_INT_SAMPLER_2D_RECT:
+    case GL_UNSIGNED_INT_SAMPLER_CUBE_MAP_ARRAY:
+      return true;
+    default:
+      return false;
+    }
+  }
+
+  // give every sampler uniform a fixed texture unit, so that drawing only
+  // has to bind textures to units
+  bool assign_texture_units() noexcept {
+    texture_units.clear();
+    GLint count = 0;
+    glGetProgramiv(*program_id, GL_ACTIVE_UNIFORMS, &count);
+    if (check_error()) {
+      std::cerr << "glGetProgramiv failed" << std::endl;
+      return false;
+    }
+
+    GLchar name[512];
+    GLint next_unit = 0;
+    for (GLint i = 0; i < count; i++) {
+      GLint size;
+      GLenum type;
+      glGetActiveUniform(*program_id, static_cast<GLuint>(i), sizeof(name),
+                         nullptr, &size, &type, name);
+      if (check_error()) {
+        std::cerr << "glGetActiveUniform failed" << std::endl;
+        return false;
+      }
+      if (!is_sampler_type(type)) {
+        continue;
+      }
+      auto location = glGetUniformLocation(*program_id, name);
+      if (location == -1) {
+        // a sampler inside a uniform block
+        continue;
+      }
+      std::string variable_name(name);
+      if (size > 1) {
+        // arrays are reported as "name[0]"
+        variable_name.resize(variable_name.rfind('['));
+      }
+      std::vector<GLint> units(static_cast<size_t>(size));
+      for (GLint j = 0; j < size; j++) {
+        units[j] = next_unit++;
+        texture_units.emplace(size > 1 ? variable_name + '[' +
+                                             std::to_string(j) + ']'
+                                       : variable_name,
+                              units[j]);
+      }
+      glProgramUniform1iv(*program_id, location, size, units.data());
+      if (check_error()) {
+        std::cerr << "glProgramUniform1iv failed" << std::endl;
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool bind_textures() noexcept {
+    auto const unit_count = texture_units.size();
+    assigned_texture_set.texture_ids.assign(unit_count, 0);
+    assigned_texture_set.targets.assign(unit_count, 0);
+    assigned_texture_set.sampler_ids.assign(unit_count, 0);
+    assigned_texture_set.cached_textures.clear();
+    for (auto const &[variable_name, texture] : assigned_textures) {
+      auto const *assigned = get_texture(texture);
+      if (!assigned) {
+        continue;
+      }
+      auto it = texture_units.find(variable_name);
+      if (it == texture_units.end()) {
+        std::cerr << "no sampler uniform " << variable_name << std::endl;
+        return false;
+      }
+      assigned_texture_set.texture_ids[it->second] = *assigned->texture_id;
+      assigned_texture_set.targets[it->second] = assigned->target;
+      if (assigned->residency) {
+        assigned_texture_set.cached_textures.push_back(
+            {it->second, assigned->texture_id, assigned->residency});
+      }
+    }
+    for (auto const &[variable_name, sampler_object] : assigned_samplers) {
+      auto it = texture_units.find(variable_name);
+      if (it != texture_units.end()) {
+        assigned_texture_set.sampler_ids[it->second] = sampler_object.get_id();
+      }
+    }
+    return bind_texture_set(assigned_texture_set);
+  }
+
+  bool bind_texture_set(const texture_set &textures) noexcept {
+    if (textures.texture_ids.empty()) {
+      return true;
+    }
+    for (auto const &cached : textures.cached_textures) {
+      if (cached.residency->evicted &&
+          !texture_cache::instance().reload(*cached.residency)) {
+        return false;
+      }
+      cached.residency->drawn = true;
+      textures.texture_ids[cached.unit] = *cached.texture_id;
+    }
+
+    auto const count = static_cast<GLsizei>(textures.texture_ids.size());
+    if constexpr (opengl::context::gl_minor_version < 5) {
+      for (GLsizei unit = 0; unit < count; unit++) {
+        if (textures.texture_ids[unit] == 0) {
+          continue;
+        }
+        glActiveTexture(GL_TEXTURE0 + unit);
+        glBindTexture(textures.targets[unit], textures.texture_ids[unit]);
+        if (check_error()) {
+          std::cerr << "glBindTexture failed" << std::endl;
+          return false;
+        }
+        render_statistics::get_current().texture_binds++;
+        glBindSampler(unit, textures.sampler_ids[unit]);
+        if (check_error()) {
+          std::cerr << "glBindSampler failed" << std::endl;
+          return false;
+        }
+      }
+    } else {
+      glBindTextures(0, count, textures.texture_ids.data());
+      if (check_error()) {
+        std::cerr << "glBindTextures failed" << std::endl;
+        return false;
+      }
+      render_statistics::get_current().texture_binds +=
+          textures.texture_ids.size();
+      glBindSamplers(0, count, textures.sampler_ids.data());
+      if (check_error()) {
+        std::cerr << "glBindSamplers failed" << std::endl;
+        return false;
+      }
+    }
+    return true;
+  }
+
   bool install() noexcept {
     if (!link()) {
       return false;
@@ -328,6 +825,7 @@ private:
       std::cerr << "glUseProgram failed" << std::endl;
       return false;
     }
+    render_statistics::get_current().program_binds++;
     return true;
   }
 
@@ -354,6 +852,49 @@ private:
     return block_names;
   }
 
+  std::optional<std::vector<std::string>> get_storage_block_names() noexcept {
+    std::vector<std::string> block_names;
+    if constexpr (opengl::context::gl_minor_version >= 3) {
+      GLint count = 0;
+      glGetProgramInterfaceiv(*program_id, GL_SHADER_STORAGE_BLOCK,
+                              GL_ACTIVE_RESOURCES, &count);
+      if (check_error()) {
+        std::cerr << "glGetProgramInterfaceiv failed" << std::endl;
+        return {};
+      }
+      GLchar name[512];
+      for (GLint i = 0; i < count; i++) {
+        glGetProgramResourceName(*program_id, GL_SHADER_STORAGE_BLOCK,
+                                 static_cast<GLuint>(i), sizeof(name),
+                                 nullptr, name);
+        if (check_error()) {
+          std::cerr << "glGetProgramResourceName failed" << std::endl;
+          return {};
+        }
+        block_names.push_back(name);
+      }
+    }
+    return block_names;
+  }
+
+  // a variable counts as assigned once it has been set, or once a texture
+  // has been assigned to it
+  bool is_assigned(std::string_view name) const noexcept {
+    if (assigned_uniform_variables.count(name)) {
+      return true;
+    }
+    if (auto it = assigned_textures.find(name);
+        it != assigned_textures.end() && get_texture(it->second)) {
+      return true;
+    }
+    for (auto const &[_, UBO] : uniform_blocks) {
+      if (UBO->is_assigned(name)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
   bool check_uniform_assignment() noexcept {
     GLint count = 0;
     glGetProgramiv(*program_id, GL_ACTIVE_UNIFORMS, &count);
@@ -362,14 +903,6 @@ private:
       return false;
     }
 
-    auto assigned_total_uniform_variables = assigned_uniform_variables;
-
-    for (auto const &[block_name, _] : uniform_blocks) {
-      assigned_total_uniform_variables.insert(
-          assigned_uniform_variables_of_blocks[block_name].begin(),
-          assigned_uniform_variables_of_blocks[block_name].end());
-    }
-
     GLchar name[512];
     for (GLint i = 0; i < count; i++) {
       GLint size;
@@ -380,7 +913,21 @@ private:
         std::cerr << "glGetActiveUniform failed" << std::endl;
         return {};
       }
-      if (assigned_total_uniform_variables.count(name) == 0) {
+      if (!arena_blocks.empty()) {
+        // members of blocks sourced from an arena are assigned as a whole
+        GLuint index = static_cast<GLuint>(i);
+        GLint block_index = -1;
+        glGetActiveUniformsiv(*program_id, 1, &index, GL_UNIFORM_BLOCK_INDEX,
+                              &block_index);
+        if (std::any_of(arena_blocks.begin(), arena_blocks.end(),
+                        [block_index](auto const &block) {
+                          return static_cast<GLint>(block.second.index) ==
+                                 block_index;
+                        })) {
+          continue;
+        }
+      }
+      if (!is_assigned(name)) {
         std::cerr << "uniform variable \"" << name << "\" is not assigned"
                   << std::endl;
         return false;
@@ -389,48 +936,12 @@ private:
     return true;
   }
 
-  bool set_uniform_of_block_by_callback(
-      const std::string &block_name, const std::string &variable_name,
-      std::function<void(opengl::uniform_buffer &UBO, GLint offset)>
-          set_function) noexcept {
-    if (!install()) {
-      return false;
-    }
-
-    auto UBO_ptr = get_uniform_block(block_name);
-    if (!UBO_ptr) {
-      return false;
-    }
-
-    GLuint index = 0;
-    auto variable_name_ptr = variable_name.c_str();
-    glGetUniformIndices(*program_id, 1, &variable_name_ptr, &index);
-    if (check_error()) {
-      std::cerr << "glGetUniformIndices failed:" << variable_name << std::endl;
-      return false;
-    }
-
-    GLint offset = -1;
-    glGetActiveUniformsiv(*program_id, 1, &index, GL_UNIFORM_OFFSET, &offset);
-    if (check_error()) {
-      std::cerr << "get GL_UNIFORM_OFFSET failed:" << variable_name
-                << std::endl;
-      return false;
-    }
-
-    set_function(*UBO_ptr, offset);
-    if (check_error()) {
-      std::cerr << "set_function failed:" << variable_name << std::endl;
-      return false;
-    }
-
-    assigned_uniform_variables_of_blocks[block_name].push_back(variable_name);
-    return true;
-  }
-
   std::shared_ptr<::opengl::uniform_buffer>
   get_uniform_block(const std::string &block_name) noexcept {
-    if (!install()) {
+    if (auto it = uniform_blocks.find(block_name); it != uniform_blocks.end()) {
+      return it->second;
+    }
+    if (!link()) {
       return {};
     }
 
@@ -440,49 +951,156 @@ private:
       return {};
     }
 
-    if (auto it = uniform_blocks.find(block_name); it != uniform_blocks.end()) {
-      return it->second;
+    GLint data_size = 0;
+    glGetActiveUniformBlockiv(*program_id, block_index,
+                              GL_UNIFORM_BLOCK_DATA_SIZE, &data_size);
+    if (check_error()) {
+      std::cerr << "glGetActiveUniformBlockiv failed" << std::endl;
+      return {};
+    }
+    assert(data_size > 0);
+    auto members = get_uniform_block_members(block_index);
+    if (!members) {
+      return {};
     }
 
+    // Programs declaring a block of the same name share its buffer, so they
+    // must agree on its layout. Declare shared blocks std140 (or shared) to
+    // get the same layout from the same declaration in every program.
     auto it = cross_program_uniform_blocks.find(block_name);
     if (it != cross_program_uniform_blocks.end()) {
       auto UBO_ptr = it->second.lock();
       if (UBO_ptr) {
+        if (!UBO_ptr->has_layout(static_cast<size_t>(data_size),
+                                 members.value())) {
+          std::cerr << "uniform block \"" << block_name
+                    << "\" has a different layout in another program"
+                    << std::endl;
+          return {};
+        }
+        uniform_blocks.emplace(block_name, UBO_ptr);
         return UBO_ptr;
       }
     }
 
-    GLint data_size = 0;
+    auto [it2, _] = uniform_blocks.emplace(
+        block_name,
+        std::make_shared<opengl::uniform_buffer>(
+            static_cast<size_t>(data_size), members.value()));
+    cross_program_uniform_blocks.insert_or_assign(block_name, it2->second);
+    return it2->second;
+  }
+
+  std::optional<opengl::uniform_buffer::member_layouts>
+  get_uniform_block_members(GLuint block_index) noexcept {
+    GLint count = 0;
     glGetActiveUniformBlockiv(*program_id, block_index,
-                              GL_UNIFORM_BLOCK_DATA_SIZE, &data_size);
+                              GL_UNIFORM_BLOCK_ACTIVE_UNIFORMS, &count);
     if (check_error()) {
       std::cerr << "glGetActiveUniformBlockiv failed" << std::endl;
       return {};
     }
-    assert(data_size > 0);
+    std::vector<GLint> indices(static_cast<size_t>(count));
+    std::vector<GLuint> uniform_indices;
+    if (count > 0) {
+      glGetActiveUniformBlockiv(*program_id, block_index,
+                                GL_UNIFORM_BLOCK_ACTIVE_UNIFORM_INDICES,
+                                indices.data());
+      uniform_indices.assign(indices.begin(), indices.end());
+    }
 
-    auto [it2, _] = uniform_blocks.emplace(
-        block_name, std::make_shared<opengl::uniform_buffer>(
-                        static_cast<size_t>(data_size)));
-    cross_program_uniform_blocks.emplace(block_name, it2->second);
-    return it2->second;
+    std::map<GLenum, std::vector<GLint>> properties;
+    for (auto pname : {GL_UNIFORM_OFFSET, GL_UNIFORM_TYPE, GL_UNIFORM_SIZE,
+                       GL_UNIFORM_ARRAY_STRIDE, GL_UNIFORM_IS_ROW_MAJOR}) {
+      auto &values = properties[pname];
+      values.resize(static_cast<size_t>(count));
+      if (count > 0) {
+        glGetActiveUniformsiv(*program_id, count, uniform_indices.data(),
+                              pname, values.data());
+      }
+    }
+    if (check_error()) {
+      std::cerr << "glGetActiveUniformsiv failed" << std::endl;
+      return {};
+    }
+
+    opengl::uniform_buffer::member_layouts members;
+    GLchar name[512];
+    for (GLint i = 0; i < count; i++) {
+      glGetActiveUniformName(*program_id, uniform_indices[i], sizeof(name),
+                             nullptr, name);
+      if (check_error()) {
+        std::cerr << "glGetActiveUniformName failed" << std::endl;
+        return {};
+      }
+      members.emplace(
+          name, opengl::uniform_buffer::member_layout{
+                    properties[GL_UNIFORM_OFFSET][i],
+                    static_cast<GLenum>(properties[GL_UNIFORM_TYPE][i]),
+                    properties[GL_UNIFORM_SIZE][i],
+                    properties[GL_UNIFORM_ARRAY_STRIDE][i],
+                    properties[GL_UNIFORM_IS_ROW_MAJOR][i] != 0});
+    }
+    return members;
   }
 
 private:
-  std::set<std::string> assigned_uniform_variables;
-  std::map<std::string, std::unique_ptr<::opengl::texture>> assigned_textures;
+  using texture_variant =
+      std::variant<std::monostate, ::opengl::texture_2D,
+                   ::opengl::texture_2D_array, ::opengl::texture_cube_map>;
+
+  static ::opengl::texture *get_texture(texture_variant &texture) noexcept {
+    return std::visit(
+        [](auto &value) -> ::opengl::texture * {
+          if constexpr (std::is_same_v<std::decay_t<decltype(value)>,
+                                       std::monostate>) {
+            return nullptr;
+          } else {
+            return &value;
+          }
+        },
+        texture);
+  }
+  static const ::opengl::texture *
+  get_texture(const texture_variant &texture) noexcept {
+    return get_texture(const_cast<texture_variant &>(texture));
+  }
+
+  std::set<std::string, std::less<>> assigned_uniform_variables;
+  std::map<std::string, GLint, std::less<>> uniform_locations;
+  std::map<GLint, uniform_cache> uniform_caches;
+  std::vector<std::string> uniform_block_names;
+  std::map<std::string, texture_variant, std::less<>> assigned_textures;
+  std::map<std::string, opengl::sampler, std::less<>> assigned_samplers;
+  // sampler uniform -> texture unit, assigned at link
+  std::map<std::string, GLuint, std::less<>> texture_units;
+  texture_set assigned_texture_set;
   std::map<GLenum,
            std::vector<std::unique_ptr<GLuint, std::function<void(GLuint *)>>>>
       shaders;
   std::optional<::opengl::vertex_array> VAO;
   std::map<std::string, std::shared_ptr<opengl::uniform_buffer>> uniform_blocks;
+  struct arena_block {
+    GLuint index;
+    GLsizeiptr data_size;
+    ::opengl::uniform_arena *arena;
+    ::opengl::uniform_arena::range block_range;
+  };
+  std::map<std::string, arena_block, std::less<>> arena_blocks;
+  std::vector<std::string> storage_block_names;
+  struct storage_block {
+    GLuint binding_point;
+    const ::opengl::buffer *storage;
+  };
+  std::map<std::string, storage_block, std::less<>> storage_blocks;
   inline static std::map<std::string, std::weak_ptr<opengl::uniform_buffer>>
       cross_program_uniform_blocks;
-  inline static std::map<std::string, std::vector<std::string>>
-      assigned_uniform_variables_of_blocks;
   bool linked{false};
   std::unique_ptr<GLuint, std::function<void(GLuint *)>> program_id{
       new GLuint(0), [](auto ptr) {
+        if (*ptr != 0) {
+          render_statistics::get_current().objects_deleted++;
+        }
         glDeleteProgram(*ptr);
         delete ptr;
       }};
@@ -5,6 +5,7 @@
 
 #include "context.hpp"
 #include "error.hpp"
+#include "render_statistics.hpp"
 
 namespace opengl {
 
@@ -23,6 +24,7 @@ protected:
         throw_exception("glCreateRenderbuffers failed");
       }
     }
+    render_statistics::get_current().objects_created++;
   }
 
   render_buffer(const render_buffer &) = default;
@@ -44,6 +46,10 @@ protected:
 
 protected:
   std::shared_ptr<GLuint> render_buffer_id{new GLuint(0), [](auto ptr) {
+                                             if (*ptr != 0) {
+                                               render_statistics::get_current()
+                                                   .objects_deleted++;
+                                             }
                                              glDeleteRenderbuffers(1, ptr);
                                              delete ptr;
                                            }};
@@ -0,0 +1,130 @@
+
+#include <iostream>
+
+#include "error.hpp"
+#include "render_statistics.hpp"
+
+namespace opengl {
+
+namespace {
+constexpr std::array<GLenum, 6> pipeline_query_targets{
+    GL_VERTICES_SUBMITTED_ARB,          GL_PRIMITIVES_SUBMITTED_ARB,
+    GL_VERTEX_SHADER_INVOCATIONS_ARB,   GL_CLIPPING_INPUT_PRIMITIVES_ARB,
+    GL_CLIPPING_OUTPUT_PRIMITIVES_ARB, GL_FRAGMENT_SHADER_INVOCATIONS_ARB};
+} // namespace
+
+render_statistics::counters render_statistics::current;
+render_statistics::counters render_statistics::last_frame;
+uint64_t render_statistics::frame_count{};
+bool render_statistics::pipeline_statistics_enabled{false};
+std::optional<render_statistics::query_set> render_statistics::active_queries;
+std::deque<render_statistics::pending_queries> render_statistics::pending;
+std::deque<render_statistics::query_set> render_statistics::free_query_sets;
+std::optional<render_statistics::pipeline_statistics>
+    render_statistics::last_pipeline_statistics;
+
+void render_statistics::end_frame() {
+  if (active_queries) {
+    end_pipeline_queries();
+  }
+  collect_pipeline_queries();
+
+  last_frame = current;
+  current = {};
+  frame_count++;
+
+  if (pipeline_statistics_enabled && !begin_pipeline_queries()) {
+    pipeline_statistics_enabled = false;
+  }
+}
+
+bool render_statistics::set_pipeline_statistics_enabled(bool enabled) {
+  if (enabled && !GLAD_GL_ARB_pipeline_statistics_query) {
+    std::cerr << "GL_ARB_pipeline_statistics_query is not supported"
+              << std::endl;
+    return false;
+  }
+  pipeline_statistics_enabled = enabled;
+  if (!enabled && active_queries) {
+    end_pipeline_queries();
+  }
+  // measuring starts with the next frame
+  return true;
+}
+
+void render_statistics::clear() {
+  if (active_queries) {
+    end_pipeline_queries();
+  }
+  for (auto const &p : pending) {
+    free_query_sets.push_back(p.queries);
+  }
+  pending.clear();
+  for (auto const &queries : free_query_sets) {
+    glDeleteQueries(static_cast<GLsizei>(queries.size()), queries.data());
+  }
+  free_query_sets.clear();
+  last_pipeline_statistics.reset();
+  pipeline_statistics_enabled = false;
+}
+
+bool render_statistics::begin_pipeline_queries() {
+  query_set queries{};
+  if (free_query_sets.empty()) {
+    glGenQueries(static_cast<GLsizei>(queries.size()), queries.data());
+    if (check_error()) {
+      std::cerr << "glGenQueries failed" << std::endl;
+      return false;
+    }
+  } else {
+    queries = free_query_sets.front();
+    free_query_sets.pop_front();
+  }
+  for (size_t i = 0; i < queries.size(); i++) {
+    glBeginQuery(pipeline_query_targets[i], queries[i]);
+  }
+  if (check_error()) {
+    std::cerr << "glBeginQuery failed" << std::endl;
+    free_query_sets.push_back(queries);
+    return false;
+  }
+  active_queries = queries;
+  return true;
+}
+
+void render_statistics::end_pipeline_queries() {
+  for (auto target : pipeline_query_targets) {
+    glEndQuery(target);
+  }
+  pending.push_back({frame_count, *active_queries});
+  active_queries.reset();
+}
+
+void render_statistics::collect_pipeline_queries() {
+  // never wait for results; frames finish in order
+  while (!pending.empty()) {
+    auto const &p = pending.front();
+    GLint available = 1;
+    for (size_t i = 0; i < p.queries.size() && available; i++) {
+      glGetQueryObjectiv(p.queries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+    }
+    if (check_error()) {
+      std::cerr << "glGetQueryObjectiv failed" << std::endl;
+      return;
+    }
+    if (!available) {
+      break;
+    }
+    std::array<GLuint64, pipeline_query_count> results{};
+    for (size_t i = 0; i < results.size(); i++) {
+      glGetQueryObjectui64v(p.queries[i], GL_QUERY_RESULT, &results[i]);
+    }
+    last_pipeline_statistics = pipeline_statistics{
+        p.frame,    results[0], results[1], results[2],
+        results[3], results[4], results[5]};
+    free_query_sets.push_back(p.queries);
+    pending.pop_front();
+  }
+}
+
+} // namespace opengl
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <optional>
+
+#include "context.hpp"
+
+namespace opengl {
+
+// Counts of the work the wrappers issue, per frame.
+//
+// The counters are bumped by the wrappers on the GL thread and end_frame()
+// moves them into the snapshot of the last frame. With pipeline statistics
+// enabled, each frame is also measured with GL_ARB_pipeline_statistics_query
+// queries, whose results arrive a few frames later.
+class render_statistics final {
+
+public:
+  struct counters {
+    size_t draw_calls{};
+    size_t primitives{};
+    size_t program_binds{};
+    size_t vertex_array_binds{};
+    // texture units bound
+    size_t texture_binds{};
+    size_t uniform_updates{};
+    size_t buffer_uploaded_bytes{};
+    size_t texture_uploaded_bytes{};
+    size_t shader_compiles{};
+    size_t program_links{};
+    size_t objects_created{};
+    size_t objects_deleted{};
+  };
+
+  struct pipeline_statistics {
+    // the frame measured, counted by end_frame()
+    uint64_t frame{};
+    uint64_t vertices_submitted{};
+    uint64_t primitives_submitted{};
+    uint64_t vertex_shader_invocations{};
+    uint64_t clipping_input_primitives{};
+    uint64_t clipping_output_primitives{};
+    uint64_t fragment_shader_invocations{};
+  };
+
+public:
+  // the counters of the frame in progress
+  static counters &get_current() noexcept { return current; }
+  static const counters &get_last_frame() noexcept { return last_frame; }
+
+  // call once per frame with a current context
+  static void end_frame();
+
+  // false if the extension is not available
+  static bool set_pipeline_statistics_enabled(bool enabled);
+  // the most recent frame whose pipeline statistics have arrived
+  static std::optional<pipeline_statistics>
+  get_last_pipeline_statistics() noexcept {
+    return last_pipeline_statistics;
+  }
+
+  // delete the query objects; call before the context is destroyed
+  static void clear();
+
+private:
+  static constexpr size_t pipeline_query_count = 6;
+  using query_set = std::array<GLuint, pipeline_query_count>;
+
+  struct pending_queries {
+    uint64_t frame;
+    query_set queries;
+  };
+
+  static bool begin_pipeline_queries();
+  static void end_pipeline_queries();
+  static void collect_pipeline_queries();
+
+private:
+  static counters current;
+  static counters last_frame;
+  static uint64_t frame_count;
+  static bool pipeline_statistics_enabled;
+  static std::optional<query_set> active_queries;
+  static std::deque<pending_queries> pending;
+  static std::deque<query_set> free_query_sets;
+  static std::optional<pipeline_statistics> last_pipeline_statistics;
+};
+
+} // namespace opengl
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <iostream>
+#include <map>
+#include <memory>
+#include <tuple>
+
+#include "context.hpp"
+#include "error.hpp"
+#include "render_statistics.hpp"
+
+namespace opengl {
+
+// Filtering and wrapping state that is bound to a texture unit separately
+// from the texture, overriding the texture's own parameters.
+class sampler final {
+
+public:
+  struct state {
+    state()
+        : min_filter{GL_LINEAR_MIPMAP_LINEAR}, mag_filter{GL_LINEAR},
+          wrap_s{GL_REPEAT}, wrap_t{GL_REPEAT}, wrap_r{GL_REPEAT} {}
+    GLint min_filter;
+    GLint mag_filter;
+    GLint wrap_s;
+    GLint wrap_t;
+    GLint wrap_r;
+
+    bool operator<(const state &rhs) const noexcept {
+      return std::tie(min_filter, mag_filter, wrap_s, wrap_t, wrap_r) <
+             std::tie(rhs.min_filter, rhs.mag_filter, rhs.wrap_s, rhs.wrap_t,
+                      rhs.wrap_r);
+    }
+  };
+
+public:
+  // samplers with equal state share one object as long as one of them is
+  // alive
+  static sampler get(const state &sampler_state) {
+    auto it = cached_samplers.find(sampler_state);
+    if (it != cached_samplers.end()) {
+      if (auto sampler_id = it->second.lock()) {
+        return sampler(std::move(sampler_id));
+      }
+    }
+    sampler result(sampler_state);
+    cached_samplers.insert_or_assign(sampler_state, result.sampler_id);
+    return result;
+  }
+
+  sampler(const sampler &) = default;
+  sampler &operator=(const sampler &) = default;
+
+  sampler(sampler &&) noexcept = default;
+  sampler &operator=(sampler &&) noexcept = default;
+
+  ~sampler() noexcept = default;
+
+  GLuint get_id() const noexcept { return *sampler_id; }
+
+private:
+  explicit sampler(std::shared_ptr<GLuint> sampler_id_)
+      : sampler_id(std::move(sampler_id_)) {}
+
+  explicit sampler(const state &sampler_state) {
+    if constexpr (opengl::context::gl_minor_version < 5) {
+      glGenSamplers(1, sampler_id.get());
+      if (check_error()) {
+        throw_exception("glGenSamplers failed");
+      }
+    } else {
+      glCreateSamplers(1, sampler_id.get());
+      if (check_error()) {
+        throw_exception("glCreateSamplers failed");
+      }
+    }
+    render_statistics::get_current().objects_created++;
+
+    for (auto [pname, value] :
+         {std::pair{GL_TEXTURE_MIN_FILTER, sampler_state.min_filter},
+          std::pair{GL_TEXTURE_MAG_FILTER, sampler_state.mag_filter},
+          std::pair{GL_TEXTURE_WRAP_S, sampler_state.wrap_s},
+          std::pair{GL_TEXTURE_WRAP_T, sampler_state.wrap_t},
+          std::pair{GL_TEXTURE_WRAP_R, sampler_state.wrap_r}}) {
+      glSamplerParameteri(*sampler_id, pname, value);
+      if (check_error()) {
+        throw_exception("glSamplerParameteri failed");
+      }
+    }
+  }
+
+private:
+  std::shared_ptr<GLuint> sampler_id{new GLuint(0), [](GLuint *ptr) {
+                                       if (*ptr != 0) {
+                                         render_statistics::get_current()
+                                             .objects_deleted++;
+                                       }
+                                       glDeleteSamplers(1, ptr);
+                                       delete ptr;
+                                     }};
+  inline static std::map<state, std::weak_ptr<GLuint>> cached_samplers;
+};
+
+} // namespace opengl
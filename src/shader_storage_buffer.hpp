@@ -0,0 +1,113 @@
+#pragma once
+
+#include <type_traits>
+#include <vector>
+
+#include "buffer.hpp"
+#include "std140.hpp"
+
+namespace opengl {
+
+// The std430 base alignment of an array element. Structs are taken at their
+// C++ alignment, so declare them alignas(16) when they hold vec3, vec4 or
+// matrix members, as std430 aligns them.
+template <typename T> constexpr size_t std430_alignment() noexcept {
+  if constexpr (std::is_same_v<T, glm::mat3>) {
+    return 16;
+  } else if constexpr (is_std140_type_v<T>) {
+    // std430 only differs from std140 in arrays and structs
+    return std140_traits<T>::alignment;
+  } else {
+    return alignof(T);
+  }
+}
+
+// An array of data_type in a shader storage buffer, e.g. per-instance
+// transforms indexed by gl_InstanceID. Needs OpenGL 4.3. Attach it to a
+// program with program::set_shader_storage_block.
+template <typename data_type>
+class shader_storage_buffer final : public buffer {
+  static_assert(std::is_trivially_copyable_v<data_type>,
+                "storage data must be trivially copyable");
+  // the std430 array stride is the element size rounded up to its alignment,
+  // e.g. 16 bytes for a vec3, while C++ packs the elements at sizeof
+  static_assert(sizeof(data_type) % std430_alignment<data_type>() == 0,
+                "the element size is not a multiple of its std430 alignment; "
+                "pad vec3 to vec4");
+
+public:
+  shader_storage_buffer() : buffer(GL_SHADER_STORAGE_BUFFER) {}
+
+  // usage is the hint for the driver whenever the storage is (re)allocated;
+  // the default suits contents rewritten every frame
+  explicit shader_storage_buffer(size_t element_count,
+                                 GLenum usage_ = GL_STREAM_DRAW)
+      : buffer(GL_SHADER_STORAGE_BUFFER), usage{usage_} {
+    if (!alloc(element_count * sizeof(data_type), usage)) {
+      throw_exception("alloc failed");
+    }
+  }
+
+  shader_storage_buffer(const shader_storage_buffer &) = delete;
+  shader_storage_buffer &operator=(const shader_storage_buffer &) = delete;
+
+  shader_storage_buffer(shader_storage_buffer &&) noexcept = default;
+  shader_storage_buffer &operator=(shader_storage_buffer &&) noexcept = default;
+
+  ~shader_storage_buffer() override = default;
+
+  size_t get_element_count() const noexcept {
+    return get_size() / sizeof(data_type);
+  }
+
+  // replace the contents; the storage is only reallocated when the size
+  // changes
+  bool write(gsl::span<const data_type> data) noexcept {
+    if (static_cast<size_t>(data.size_bytes()) == get_size()) {
+      return write_part(data, 0);
+    }
+    return write_all(data, usage);
+  }
+
+  bool write(const std::vector<data_type> &data) noexcept {
+    return write(gsl::span<const data_type>(data.data(), data.size()));
+  }
+
+  // overwrite the elements starting at first
+  bool update(gsl::span<const data_type> data, size_t first) noexcept {
+    if (first + static_cast<size_t>(data.size()) > get_element_count()) {
+      std::cerr << "storage elements out of range" << std::endl;
+      return false;
+    }
+    return write_part(data, static_cast<GLintptr>(first * sizeof(data_type)));
+  }
+
+  // copy the elements starting at first back into data; waits for the
+  // commands writing them to finish
+  bool read(gsl::span<data_type> data, size_t first = 0) noexcept {
+    if (first + static_cast<size_t>(data.size()) > get_element_count()) {
+      std::cerr << "storage elements out of range" << std::endl;
+      return false;
+    }
+    auto const offset = static_cast<GLintptr>(first * sizeof(data_type));
+    auto const size = static_cast<GLsizeiptr>(data.size_bytes());
+    if constexpr (opengl::context::gl_minor_version < 5) {
+      if (!bind()) {
+        return false;
+      }
+      glGetBufferSubData(target, offset, size, data.data());
+    } else {
+      glGetNamedBufferSubData(*buffer_id, offset, size, data.data());
+    }
+    if (check_error()) {
+      std::cerr << "glGetBufferSubData failed" << std::endl;
+      return false;
+    }
+    return true;
+  }
+
+private:
+  GLenum usage{GL_STREAM_DRAW};
+};
+
+} // namespace opengl
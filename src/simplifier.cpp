@@ -0,0 +1,239 @@
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <unordered_map>
+
+#include "simplifier.hpp"
+
+namespace opengl {
+
+namespace {
+
+// symmetric 4x4 matrix of the plane equations, stored as its upper triangle
+struct quadric {
+  double a00{}, a01{}, a02{}, a03{}, a11{}, a12{}, a13{}, a22{}, a23{}, a33{};
+
+  static quadric from_plane(double a, double b, double c, double d) {
+    quadric q;
+    q.a00 = a * a;
+    q.a01 = a * b;
+    q.a02 = a * c;
+    q.a03 = a * d;
+    q.a11 = b * b;
+    q.a12 = b * c;
+    q.a13 = b * d;
+    q.a22 = c * c;
+    q.a23 = c * d;
+    q.a33 = d * d;
+    return q;
+  }
+
+  quadric &operator+=(const quadric &rhs) {
+    a00 += rhs.a00;
+    a01 += rhs.a01;
+    a02 += rhs.a02;
+    a03 += rhs.a03;
+    a11 += rhs.a11;
+    a12 += rhs.a12;
+    a13 += rhs.a13;
+    a22 += rhs.a22;
+    a23 += rhs.a23;
+    a33 += rhs.a33;
+    return *this;
+  }
+
+  double error(const glm::vec3 &v) const {
+    double x = v.x, y = v.y, z = v.z;
+    return a00 * x * x + 2 * a01 * x * y + 2 * a02 * x * z + 2 * a03 * x +
+           a11 * y * y + 2 * a12 * y * z + 2 * a13 * y + a22 * z * z +
+           2 * a23 * z + a33;
+  }
+};
+
+struct collapse {
+  double cost;
+  GLuint from;
+  GLuint to;
+};
+
+} // namespace
+
+std::vector<GLuint> simplify_indices(gsl::span<const glm::vec3> positions,
+                                     gsl::span<const GLuint> indices,
+                                     size_t target_index_count,
+                                     float max_error) {
+  std::vector<GLuint> result(indices.begin(), indices.end());
+  auto const vertex_count = static_cast<size_t>(positions.size());
+  if (result.size() % 3 != 0 || vertex_count == 0) {
+    return result;
+  }
+
+  glm::vec3 min_corner = positions[0];
+  glm::vec3 max_corner = positions[0];
+  for (auto const &position : positions) {
+    min_corner = glm::min(min_corner, position);
+    max_corner = glm::max(max_corner, position);
+  }
+  auto const extent_vector = max_corner - min_corner;
+  double const extent =
+      std::max({extent_vector.x, extent_vector.y, extent_vector.z});
+  double const error_limit = (max_error * extent) * (max_error * extent);
+
+  std::vector<quadric> quadrics(vertex_count);
+  std::unordered_map<uint64_t, uint32_t> edge_use_count;
+  auto edge_key = [](GLuint a, GLuint b) {
+    return (static_cast<uint64_t>(std::min(a, b)) << 32) | std::max(a, b);
+  };
+  for (size_t i = 0; i < result.size(); i += 3) {
+    auto const &p0 = positions[result[i]];
+    auto const &p1 = positions[result[i + 1]];
+    auto const &p2 = positions[result[i + 2]];
+    auto normal = glm::cross(p1 - p0, p2 - p0);
+    auto const length = glm::length(normal);
+    if (length > 0) {
+      normal = normal / length;
+      auto const plane = quadric::from_plane(normal.x, normal.y, normal.z,
+                                             -glm::dot(normal, p0));
+      for (size_t j = 0; j < 3; j++) {
+        quadrics[result[i + j]] += plane;
+      }
+    }
+    for (size_t j = 0; j < 3; j++) {
+      edge_use_count[edge_key(result[i + j], result[i + (j + 1) % 3])]++;
+    }
+  }
+
+  // vertices on open borders or non-manifold edges stay where they are
+  std::vector<bool> locked(vertex_count, false);
+  for (auto const &[key, count] : edge_use_count) {
+    if (count != 2) {
+      locked[static_cast<GLuint>(key >> 32)] = true;
+      locked[static_cast<GLuint>(key & 0xffffffff)] = true;
+    }
+  }
+
+  auto flips = [](const glm::vec3 &p0, const glm::vec3 &p1,
+                  const glm::vec3 &p2, const glm::vec3 &new_p0) {
+    auto const before = glm::cross(p1 - p0, p2 - p0);
+    auto const after = glm::cross(p1 - new_p0, p2 - new_p0);
+    return glm::dot(before, after) <= 0;
+  };
+
+  std::vector<size_t> triangle_offsets(vertex_count + 1);
+  std::vector<size_t> vertex_triangles;
+  std::vector<GLuint> remap(vertex_count);
+  std::vector<bool> touched(vertex_count);
+  std::vector<collapse> candidates;
+
+  while (result.size() > target_index_count) {
+    // vertex -> triangle adjacency of the current index list
+    std::fill(triangle_offsets.begin(), triangle_offsets.end(), 0);
+    for (auto index : result) {
+      triangle_offsets[index + 1]++;
+    }
+    std::partial_sum(triangle_offsets.begin(), triangle_offsets.end(),
+                     triangle_offsets.begin());
+    vertex_triangles.resize(result.size());
+    {
+      auto fill_offsets = triangle_offsets;
+      for (size_t i = 0; i < result.size(); i++) {
+        vertex_triangles[fill_offsets[result[i]]++] = i / 3;
+      }
+    }
+
+    candidates.clear();
+    for (size_t i = 0; i < result.size(); i += 3) {
+      for (size_t j = 0; j < 3; j++) {
+        auto const a = result[i + j];
+        auto const b = result[i + (j + 1) % 3];
+        for (auto [from, to] : {std::pair{a, b}, std::pair{b, a}}) {
+          if (locked[from]) {
+            continue;
+          }
+          auto q = quadrics[from];
+          q += quadrics[to];
+          auto const cost = q.error(positions[to]);
+          if (cost <= error_limit) {
+            candidates.push_back({cost, from, to});
+          }
+        }
+      }
+    }
+    std::sort(candidates.begin(), candidates.end(),
+              [](auto const &lhs, auto const &rhs) {
+                return lhs.cost < rhs.cost;
+              });
+
+    std::iota(remap.begin(), remap.end(), 0);
+    std::fill(touched.begin(), touched.end(), false);
+    size_t const triangles_to_remove =
+        std::max<size_t>((result.size() - target_index_count) / 3, 1);
+    size_t removed_triangles = 0;
+
+    for (auto const &[cost, from, to] : candidates) {
+      if (removed_triangles >= triangles_to_remove) {
+        break;
+      }
+      if (touched[from] || touched[to]) {
+        continue;
+      }
+
+      bool rejected = false;
+      size_t degenerate_count = 0;
+      for (auto k = triangle_offsets[from]; k < triangle_offsets[from + 1];
+           k++) {
+        auto const *triangle = &result[vertex_triangles[k] * 3];
+        if (triangle[0] == to || triangle[1] == to || triangle[2] == to) {
+          degenerate_count++;
+          continue;
+        }
+        // rotate so that the collapsed vertex comes first
+        auto const slot =
+            triangle[0] == from ? 0 : (triangle[1] == from ? 1 : 2);
+        if (flips(positions[triangle[slot]],
+                  positions[triangle[(slot + 1) % 3]],
+                  positions[triangle[(slot + 2) % 3]], positions[to])) {
+          rejected = true;
+          break;
+        }
+      }
+      if (rejected) {
+        continue;
+      }
+
+      remap[from] = to;
+      quadrics[to] += quadrics[from];
+      touched[to] = true;
+      for (auto k = triangle_offsets[from]; k < triangle_offsets[from + 1];
+           k++) {
+        auto const *triangle = &result[vertex_triangles[k] * 3];
+        for (size_t j = 0; j < 3; j++) {
+          touched[triangle[j]] = true;
+        }
+      }
+      removed_triangles += degenerate_count;
+    }
+
+    if (removed_triangles == 0) {
+      break;
+    }
+
+    size_t write_pos = 0;
+    for (size_t i = 0; i < result.size(); i += 3) {
+      auto const a = remap[result[i]];
+      auto const b = remap[result[i + 1]];
+      auto const c = remap[result[i + 2]];
+      if (a == b || b == c || a == c) {
+        continue;
+      }
+      result[write_pos++] = a;
+      result[write_pos++] = b;
+      result[write_pos++] = c;
+    }
+    result.resize(write_pos);
+  }
+  return result;
+}
+
+} // namespace opengl
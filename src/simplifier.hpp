@@ -0,0 +1,23 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <gsl/gsl>
+#include <vector>
+
+#include "glad/glad.h"
+
+namespace opengl {
+
+// Simplify a triangle list by quadric-error half-edge collapse (Garland &
+// Heckbert). Vertices are never moved or created, so the result indexes into
+// the same vertex buffer as the input. Border vertices (including attribute
+// seams) are kept fixed to avoid cracks.
+//
+// max_error is relative to the extent of the mesh; the result may contain
+// more than target_index_count indices if no further collapse stays below it.
+std::vector<GLuint> simplify_indices(gsl::span<const glm::vec3> positions,
+                                     gsl::span<const GLuint> indices,
+                                     size_t target_index_count,
+                                     float max_error = 0.01f);
+
+} // namespace opengl
@@ -0,0 +1,160 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <glm/glm.hpp>
+#include <type_traits>
+
+#include "glad/glad.h"
+
+namespace opengl {
+
+// An array member of a std140 block. Every element starts on a 16 byte
+// boundary, as std140 requires.
+template <typename T, size_t N> struct std140_array {
+  struct element {
+    alignas(16) T value;
+  };
+  std::array<element, N> elements;
+
+  T &operator[](size_t i) noexcept { return elements[i].value; }
+  const T &operator[](size_t i) const noexcept { return elements[i].value; }
+  static constexpr size_t size() noexcept { return N; }
+};
+
+// base alignment, size and reflected type of the std140 members
+template <typename T> struct std140_traits;
+template <> struct std140_traits<GLfloat> {
+  static constexpr GLuint alignment = 4;
+  static constexpr GLuint size = 4;
+  static constexpr GLenum type = GL_FLOAT;
+};
+template <> struct std140_traits<GLint> {
+  static constexpr GLuint alignment = 4;
+  static constexpr GLuint size = 4;
+  static constexpr GLenum type = GL_INT;
+};
+template <> struct std140_traits<GLuint> {
+  static constexpr GLuint alignment = 4;
+  static constexpr GLuint size = 4;
+  static constexpr GLenum type = GL_UNSIGNED_INT;
+};
+template <> struct std140_traits<glm::vec2> {
+  static constexpr GLuint alignment = 8;
+  static constexpr GLuint size = 8;
+  static constexpr GLenum type = GL_FLOAT_VEC2;
+};
+template <> struct std140_traits<glm::vec3> {
+  static constexpr GLuint alignment = 16;
+  static constexpr GLuint size = 12;
+  static constexpr GLenum type = GL_FLOAT_VEC3;
+};
+template <> struct std140_traits<glm::vec4> {
+  static constexpr GLuint alignment = 16;
+  static constexpr GLuint size = 16;
+  static constexpr GLenum type = GL_FLOAT_VEC4;
+};
+template <> struct std140_traits<glm::mat4> {
+  static constexpr GLuint alignment = 16;
+  static constexpr GLuint size = 64;
+  static constexpr GLenum type = GL_FLOAT_MAT4;
+};
+
+template <typename T, typename = void>
+struct is_std140_type : std::false_type {};
+template <typename T>
+struct is_std140_type<T, std::void_t<decltype(std140_traits<T>::size)>>
+    : std::true_type {};
+template <typename T>
+inline constexpr bool is_std140_type_v = is_std140_type<T>::value;
+
+struct std140_member {
+  // as reflected, without the "[0]" of arrays
+  const char *name;
+  GLenum type;
+  GLint count;
+  // 0 for non-array members
+  GLuint array_stride;
+  GLuint alignment;
+  GLuint size;
+  GLuint offset;
+};
+
+// member name of type T at offset, e.g.
+// std140_member_of<glm::mat4>("view", offsetof(matrices, view))
+template <typename T>
+constexpr std140_member std140_member_of(const char *name,
+                                         size_t offset) noexcept {
+  using traits = std140_traits<T>;
+  return {name,
+          traits::type,
+          1,
+          0,
+          traits::alignment,
+          traits::size,
+          static_cast<GLuint>(offset)};
+}
+
+template <typename T, size_t N>
+constexpr std140_member
+std140_array_member_of(const char *name, size_t offset) noexcept {
+  using traits = std140_traits<T>;
+  constexpr auto stride = static_cast<GLuint>(
+      sizeof(typename std140_array<T, N>::element));
+  static_assert(stride % 16 == 0, "unexpected std140 array stride");
+  return {name,
+          traits::type,
+          static_cast<GLint>(N),
+          stride,
+          16,
+          static_cast<GLuint>(stride * N),
+          static_cast<GLuint>(offset)};
+}
+
+// The members of a C++ struct mirroring a GLSL std140 block, in declaration
+// order.
+template <size_t N> struct std140_layout {
+  GLuint size;
+  std::array<std140_member, N> members;
+
+  // whether every member sits where std140 places it after the previous one
+  // and the struct covers them all
+  constexpr bool is_valid() const noexcept {
+    GLuint end = 0;
+    for (auto const &member : members) {
+      auto const expected =
+          (end + member.alignment - 1) / member.alignment * member.alignment;
+      if (member.offset != expected) {
+        return false;
+      }
+      end = member.offset + member.size;
+    }
+    return size >= end;
+  }
+};
+
+template <typename block_type, typename... member_types>
+constexpr std140_layout<sizeof...(member_types)>
+make_std140_layout(member_types... members) noexcept {
+  static_assert(std::is_trivially_copyable_v<block_type>,
+                "uniform blocks are copied bytewise");
+  return {static_cast<GLuint>(sizeof(block_type)), {{members...}}};
+}
+
+// Specialize with a static constexpr std140_layout named value for structs
+// passed to program::set_uniform_block, e.g.
+//
+//   struct matrices {
+//     glm::mat4 projection;
+//     glm::mat4 view;
+//   };
+//   template <> struct opengl::uniform_block_layout<matrices> {
+//     static constexpr auto value = opengl::make_std140_layout<matrices>(
+//         opengl::std140_member_of<glm::mat4>(
+//             "projection", offsetof(matrices, projection)),
+//         opengl::std140_member_of<glm::mat4>(
+//             "view", offsetof(matrices, view)));
+//   };
+template <typename T> struct uniform_block_layout;
+
+} // namespace opengl
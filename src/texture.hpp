@@ -1,24 +1,68 @@
 #pragma once
 
+#include <algorithm>
 #include <array>
+#include <cmath>
 #include <filesystem>
 #include <gsl/gsl>
 #include <iostream>
 #include <memory>
+#include <optional>
 #include <stb_image.h>
 #include <stdexcept>
+#include <tuple>
+#include <vector>
 
+#include "context.hpp"
 #include "error.hpp"
+#include "profiler.hpp"
+#include "render_statistics.hpp"
 
 namespace opengl {
 
+// What texture_cache tracks of a texture it manages, shared by the copies of
+// the texture.
+struct texture_residency {
+  // bound for drawing since the cache last looked
+  bool drawn{};
+  // the video memory was released; binding through a program reloads it
+  bool evicted{};
+};
+
 class texture {
 
 public:
+  // what the image holds; decides the internal format together with the
+  // channels of the source image
+  enum class usage {
+    // sRGB encoded color: SRGB8(_ALPHA8), grey images as R8/RG8 swizzled
+    // to {R, R, R, 1}
+    color = 1,
+    // linear values such as specular maps: R8 to RGBA8
+    data,
+    // the first channel only: R8
+    mask,
+    // tangent-space normals as RG8; z is reconstructed in the shader
+    normal_map,
+    // 16-bit images as R16 to RGBA16, everything else as half floats
+    hdr,
+  };
+
   struct extra_config {
-    extra_config() : generate_mipmap{true}, flip_y{true} {}
+    extra_config()
+        : generate_mipmap{true}, flip_y{true}, streaming{false},
+          image_usage{usage::color} {}
     bool generate_mipmap;
     bool flip_y;
+    // load through texture_streamer, coarsest levels first
+    bool streaming;
+    usage image_usage;
+
+    bool operator<(const extra_config &rhs) const noexcept {
+      return std::tie(generate_mipmap, flip_y, streaming, image_usage) <
+             std::tie(rhs.generate_mipmap, rhs.flip_y, rhs.streaming,
+                      rhs.image_usage);
+    }
   };
 
   enum class type {
@@ -32,9 +76,17 @@ public:
   template <typename value_type>
   bool set_parameter(GLenum pname, value_type value) noexcept {
     if constexpr (std::is_same_v<value_type, GLint>) {
-      glTexParameteri(target, pname, value);
+      if constexpr (opengl::context::gl_minor_version < 5) {
+        glTexParameteri(target, pname, value);
+      } else {
+        glTextureParameteri(*texture_id, pname, value);
+      }
     } else if constexpr (std::is_same_v<value_type, GLfloat>) {
-      glTexParameterf(target, pname, value);
+      if constexpr (opengl::context::gl_minor_version < 5) {
+        glTexParameterf(target, pname, value);
+      } else {
+        glTextureParameterf(*texture_id, pname, value);
+      }
     } else {
       static_assert("not supported value type");
     }
@@ -45,24 +97,51 @@ public:
     return true;
   }
 
+  // estimated video memory of all levels and faces
+  size_t get_memory_size() const noexcept { return *memory_size; }
+
+  bool is_streamed() const noexcept { return streamed; }
+
+  // Unlike binding through a program, this does not reload a texture evicted
+  // by texture_cache.
   bool use(GLenum unit) {
-    glActiveTexture(unit);
-    if (check_error()) {
-      std::cerr << "glActiveTexture failed" << std::endl;
-      return false;
+    if (residency) {
+      residency->drawn = true;
     }
-    if (!bind()) {
-      return false;
+    if constexpr (opengl::context::gl_minor_version < 5) {
+      glActiveTexture(unit);
+      if (check_error()) {
+        std::cerr << "glActiveTexture failed" << std::endl;
+        return false;
+      }
+      if (!bind()) {
+        return false;
+      }
+    } else {
+      glBindTextureUnit(unit - GL_TEXTURE0, *texture_id);
+      if (check_error()) {
+        std::cerr << "glBindTextureUnit failed" << std::endl;
+        return false;
+      }
+      render_statistics::get_current().texture_binds++;
     }
     return true;
   }
 
 protected:
   texture(GLenum target_) : target{target_} {
-    glGenTextures(1, texture_id.get());
-    if (check_error()) {
-      throw_exception("glBindTexture failed");
+    if constexpr (opengl::context::gl_minor_version < 5) {
+      glGenTextures(1, texture_id.get());
+      if (check_error()) {
+        throw_exception("glGenTextures failed");
+      }
+    } else {
+      glCreateTextures(target, 1, texture_id.get());
+      if (check_error()) {
+        throw_exception("glCreateTextures failed");
+      }
     }
+    render_statistics::get_current().objects_created++;
   }
 
   texture(const texture &) = default;
@@ -71,57 +150,274 @@ protected:
   texture(texture &&) noexcept = default;
   texture &operator=(texture &&) noexcept = default;
 
-  bool load_texture_image(std::filesystem::path image, GLenum loading_target,
-                          const extra_config &config) noexcept {
+  struct pixel_format {
+    GLenum internal_format{};
+    // client data layout passed to glTexImage2D
+    GLenum format{};
+    GLenum type{};
+    // channels to request from stb_image
+    int channels{};
+    // estimated bytes per texel in video memory
+    size_t texel_size{};
+  };
+
+  static pixel_format choose_pixel_format(usage image_usage, int channels,
+                                          bool is_16_bit) noexcept {
+    static constexpr std::array<GLenum, 4> client_formats{GL_RED, GL_RG,
+                                                          GL_RGB, GL_RGBA};
+    pixel_format result;
+    result.channels = channels;
+    result.type = GL_UNSIGNED_BYTE;
+    switch (image_usage) {
+    case usage::color: {
+      static constexpr std::array<GLenum, 4> internal_formats{
+          GL_R8, GL_RG8, GL_SRGB8, GL_SRGB8_ALPHA8};
+      result.internal_format = internal_formats[channels - 1];
+      break;
+    }
+    case usage::data: {
+      static constexpr std::array<GLenum, 4> internal_formats{
+          GL_R8, GL_RG8, GL_RGB8, GL_RGBA8};
+      result.internal_format = internal_formats[channels - 1];
+      break;
+    }
+    case usage::mask:
+      result.channels = 1;
+      result.internal_format = GL_R8;
+      break;
+    case usage::normal_map:
+      // blue is dropped by the driver during the upload
+      result.channels = 3;
+      result.internal_format = GL_RG8;
+      result.format = GL_RGB;
+      result.texel_size = 2;
+      return result;
+    case usage::hdr: {
+      static constexpr std::array<GLenum, 4> unorm_formats{
+          GL_R16, GL_RG16, GL_RGB16, GL_RGBA16};
+      static constexpr std::array<GLenum, 4> float_formats{
+          GL_R16F, GL_RG16F, GL_RGB16F, GL_RGBA16F};
+      result.internal_format = is_16_bit ? unorm_formats[channels - 1]
+                                         : float_formats[channels - 1];
+      result.type = is_16_bit ? GL_UNSIGNED_SHORT : GL_FLOAT;
+      result.format = client_formats[result.channels - 1];
+      result.texel_size = static_cast<size_t>(result.channels) * 2;
+      return result;
+    }
+    }
+    result.format = client_formats[result.channels - 1];
+    result.texel_size = static_cast<size_t>(result.channels);
+    return result;
+  }
+
+  // show one- and two-channel color images as opaque grey instead of red
+  bool set_grey_swizzle(usage image_usage, int channels) noexcept {
+    if (image_usage != usage::color || channels > 2) {
+      return true;
+    }
+    std::array<GLint, 4> swizzle{GL_RED, GL_RED, GL_RED, GL_ONE};
+    if constexpr (opengl::context::gl_minor_version < 5) {
+      glTexParameteriv(target, GL_TEXTURE_SWIZZLE_RGBA, swizzle.data());
+    } else {
+      glTextureParameteriv(*texture_id, GL_TEXTURE_SWIZZLE_RGBA,
+                           swizzle.data());
+    }
+    if (check_error()) {
+      std::cerr << "set GL_TEXTURE_SWIZZLE_RGBA failed" << std::endl;
+      return false;
+    }
+    return true;
+  }
+
+  static GLsizei full_level_count(GLsizei width, GLsizei height) noexcept {
+    return static_cast<GLsizei>(std::log2(std::max(width, height))) + 1;
+  }
 
+  // On the DSA path the first image allocates immutable storage for all
+  // faces or layers and mip levels, and every image is then copied into it.
+  // layer_count is only used by texture arrays.
+  bool upload_image(GLint layer, GLsizei layer_count, GLsizei width,
+                    GLsizei height, const pixel_format &pixel,
+                    const void *data, bool with_mipmap) noexcept {
+    opengl::profiler::zone zone("texture upload");
+    render_statistics::get_current().texture_uploaded_bytes +=
+        static_cast<size_t>(width) * height * pixel.texel_size;
+    if constexpr (opengl::context::gl_minor_version < 5) {
+      if (target == GL_TEXTURE_2D_ARRAY) {
+        if (layer == 0) {
+          glTexImage3D(target, 0, pixel.internal_format, width, height,
+                       layer_count, 0, pixel.format, pixel.type, nullptr);
+          if (check_error()) {
+            std::cerr << "glTexImage3D failed" << std::endl;
+            return false;
+          }
+        }
+        glTexSubImage3D(target, 0, 0, 0, layer, width, height, 1,
+                        pixel.format, pixel.type, data);
+        if (check_error()) {
+          std::cerr << "glTexSubImage3D failed" << std::endl;
+          return false;
+        }
+        return true;
+      }
+      auto const image_target =
+          target == GL_TEXTURE_CUBE_MAP
+              ? static_cast<GLenum>(GL_TEXTURE_CUBE_MAP_POSITIVE_X + layer)
+              : target;
+      glTexImage2D(image_target, 0, pixel.internal_format, width, height, 0,
+                   pixel.format, pixel.type, data);
+      if (check_error()) {
+        std::cerr << "glTexImage2D failed" << std::endl;
+        return false;
+      }
+    } else {
+      if (layer == 0) {
+        auto const levels = with_mipmap ? full_level_count(width, height) : 1;
+        if (target == GL_TEXTURE_2D_ARRAY) {
+          glTextureStorage3D(*texture_id, levels, pixel.internal_format,
+                             width, height, layer_count);
+        } else {
+          glTextureStorage2D(*texture_id, levels, pixel.internal_format,
+                             width, height);
+        }
+        if (check_error()) {
+          std::cerr << "glTextureStorage failed" << std::endl;
+          return false;
+        }
+      }
+      if (target == GL_TEXTURE_2D) {
+        glTextureSubImage2D(*texture_id, 0, 0, 0, width, height, pixel.format,
+                            pixel.type, data);
+      } else {
+        glTextureSubImage3D(*texture_id, 0, 0, 0, layer, width, height, 1,
+                            pixel.format, pixel.type, data);
+      }
+      if (check_error()) {
+        std::cerr << "glTextureSubImage failed" << std::endl;
+        return false;
+      }
+    }
+    return true;
+  }
+
+  struct decoded_image {
+    std::unique_ptr<void, void (*)(void *)> data{nullptr, stbi_image_free};
+    GLsizei width{};
+    GLsizei height{};
+    pixel_format pixel;
+  };
+
+  // channels overrides the channel count of the file unless it is 0
+  static std::optional<decoded_image>
+  decode_image(const std::filesystem::path &image, const extra_config &config,
+               int channels = 0) noexcept {
     if (!std::filesystem::exists(image)) {
       std::cerr << "no image " << image << std::endl;
-      return false;
+      return {};
     }
     stbi_set_flip_vertically_on_load(config.flip_y);
 
+    auto const path = image.string();
     int width, height, channel;
-    auto *data =
-        stbi_load(image.string().c_str(), &width, &height, &channel, 0);
-    if (!data) {
+    if (!stbi_info(path.c_str(), &width, &height, &channel)) {
+      std::cerr << "stbi_info " << image << " failed" << std::endl;
+      return {};
+    }
+    auto const is_16_bit = stbi_is_16_bit(path.c_str()) != 0;
+    decoded_image result;
+    result.pixel = choose_pixel_format(
+        config.image_usage, channels != 0 ? channels : channel, is_16_bit);
+
+    auto const requested_channels = result.pixel.channels;
+    if (result.pixel.type == GL_UNSIGNED_SHORT) {
+      result.data.reset(stbi_load_16(path.c_str(), &width, &height, &channel,
+                                     requested_channels));
+    } else if (result.pixel.type == GL_FLOAT) {
+      result.data.reset(stbi_loadf(path.c_str(), &width, &height, &channel,
+                                   requested_channels));
+    } else {
+      result.data.reset(stbi_load(path.c_str(), &width, &height, &channel,
+                                  requested_channels));
+    }
+    if (!result.data) {
       std::cerr << "stbi_load " << image << " failed" << std::endl;
+      return {};
+    }
+    result.width = width;
+    result.height = height;
+    return result;
+  }
+
+  // face is the cube map face, 0 for other targets
+  bool load_texture_image(std::filesystem::path image, GLint face,
+                          const extra_config &config) noexcept {
+    auto decoded = decode_image(image, config);
+    if (!decoded) {
       return false;
     }
-    auto cleanup = gsl::finally([data]() { stbi_image_free(data); });
-    GLenum format = 0;
-    if (channel == 3) {
-      format = GL_RGB;
-    } else if (channel == 4) {
-      format = GL_RGBA;
-    } else {
-      std::cerr << "unsupported channels" << std::endl;
+    auto const &pixel = decoded->pixel;
+    auto const width = decoded->width;
+    auto const height = decoded->height;
+
+    // rows of one- and three-channel images are not 4-byte aligned
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    auto const uploaded = upload_image(face, 1, width, height, pixel,
+                                       decoded->data.get(),
+                                       config.generate_mipmap);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    if (!uploaded) {
       return false;
     }
+    if (!set_grey_swizzle(config.image_usage, pixel.channels)) {
+      return false;
+    }
+    *memory_size += static_cast<size_t>(width) * height * pixel.texel_size;
+    return true;
+  }
 
-    glTexImage2D(loading_target, 0, GL_RGBA, width, height, 0, format,
-                 GL_UNSIGNED_BYTE, data);
+  bool generate_mipmap() noexcept {
+    if constexpr (opengl::context::gl_minor_version < 5) {
+      glGenerateMipmap(target);
+    } else {
+      glGenerateTextureMipmap(*texture_id);
+    }
     if (check_error()) {
-      std::cerr << "glTexImage2D failed" << std::endl;
+      std::cerr << "glGenerateMipmap failed" << std::endl;
       return false;
     }
-
+    // the whole chain adds a third to the base level
+    *memory_size += *memory_size / 3;
     return true;
   }
+
   bool bind() noexcept {
     glBindTexture(target, *texture_id);
     if (check_error()) {
       std::cerr << "glBindTexture failed" << std::endl;
       return false;
     }
+    render_statistics::get_current().texture_binds++;
     return true;
   }
 
 protected:
+  friend class program;
+  friend class texture_cache;
+  friend class texture_streamer;
   std::shared_ptr<GLuint> texture_id{new GLuint(0), [](GLuint *ptr) {
+                                       if (*ptr != 0) {
+                                         render_statistics::get_current()
+                                             .objects_deleted++;
+                                       }
                                        glDeleteTextures(1, ptr);
                                        delete ptr;
                                      }};
   GLenum target{};
+  // shared by copies, since streamed textures change size after creation
+  std::shared_ptr<size_t> memory_size{std::make_shared<size_t>(0)};
+  bool streamed{false};
+  // set for the textures of texture_cache only
+  std::shared_ptr<texture_residency> residency;
 };
 
 class frame_buffer;
@@ -131,11 +427,16 @@ public:
   explicit texture_2D(std::filesystem::path image, extra_config config = {})
       : texture(GL_TEXTURE_2D) {
 
-    if (!bind()) {
-      throw_exception("bind failed");
+    if (config.streaming) {
+      throw_exception("streamed textures are created by texture_streamer");
+    }
+    if constexpr (opengl::context::gl_minor_version < 5) {
+      if (!bind()) {
+        throw_exception("bind failed");
+      }
     }
 
-    if (!load_texture_image(image, GL_TEXTURE_2D, config)) {
+    if (!load_texture_image(image, 0, config)) {
       throw_exception("load_texture_image failed");
     }
     if (!set_parameter(GL_TEXTURE_MIN_FILTER, GL_LINEAR)) {
@@ -144,25 +445,37 @@ public:
     if (!set_parameter(GL_TEXTURE_MAG_FILTER, GL_LINEAR)) {
       throw_exception("set GL_TEXTURE_MAG_FILTER failed");
     }
-    if (config.generate_mipmap) {
-      glGenerateMipmap(target);
-      if (check_error()) {
-        throw_exception("glGenerateMipmap failed");
-      }
+    if (config.generate_mipmap && !generate_mipmap()) {
+      throw_exception("generate_mipmap failed");
     }
   }
 
-  explicit texture_2D(GLsizei width, GLsizei height) : texture(GL_TEXTURE_2D) {
+  // a render target; internal_format must be one of the color, depth or
+  // depth-stencil formats listed in render_target_format
+  explicit texture_2D(GLsizei width, GLsizei height,
+                      GLenum internal_format = GL_RGB8)
+      : texture(GL_TEXTURE_2D) {
 
-    if (!bind()) {
-      throw_exception("bind failed");
+    auto const pixel = render_target_format(internal_format);
+    if (!pixel) {
+      throw_exception("unsupported render target format");
     }
-
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB,
-                 GL_UNSIGNED_BYTE, nullptr);
-    if (check_error()) {
-      throw_exception("glTexImage2D failed");
+    if constexpr (opengl::context::gl_minor_version < 5) {
+      if (!bind()) {
+        throw_exception("bind failed");
+      }
+      glTexImage2D(GL_TEXTURE_2D, 0, internal_format, width, height, 0,
+                   pixel->format, pixel->type, nullptr);
+      if (check_error()) {
+        throw_exception("glTexImage2D failed");
+      }
+    } else {
+      glTextureStorage2D(*texture_id, 1, internal_format, width, height);
+      if (check_error()) {
+        throw_exception("glTextureStorage2D failed");
+      }
     }
+    *memory_size = static_cast<size_t>(width) * height * pixel->texel_size;
 
     if (!set_parameter(GL_TEXTURE_MIN_FILTER, GL_LINEAR)) {
       throw_exception("set GL_TEXTURE_MIN_FILTER failed");
@@ -181,23 +494,128 @@ public:
   ~texture_2D() override = default;
 
 private:
+  static std::optional<pixel_format>
+  render_target_format(GLenum internal_format) noexcept {
+    static constexpr std::array<pixel_format, 17> formats{{
+        {GL_R8, GL_RED, GL_UNSIGNED_BYTE, 1, 1},
+        {GL_RG8, GL_RG, GL_UNSIGNED_BYTE, 2, 2},
+        {GL_RGB8, GL_RGB, GL_UNSIGNED_BYTE, 3, 4},
+        {GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, 4, 4},
+        {GL_SRGB8_ALPHA8, GL_RGBA, GL_UNSIGNED_BYTE, 4, 4},
+        {GL_RGB10_A2, GL_RGBA, GL_UNSIGNED_INT_2_10_10_10_REV, 4, 4},
+        {GL_R11F_G11F_B10F, GL_RGB, GL_FLOAT, 3, 4},
+        {GL_R16F, GL_RED, GL_FLOAT, 1, 2},
+        {GL_RG16F, GL_RG, GL_FLOAT, 2, 4},
+        {GL_RGBA16F, GL_RGBA, GL_FLOAT, 4, 8},
+        {GL_R32F, GL_RED, GL_FLOAT, 1, 4},
+        {GL_RG32F, GL_RG, GL_FLOAT, 2, 8},
+        {GL_RGBA32F, GL_RGBA, GL_FLOAT, 4, 16},
+        {GL_DEPTH_COMPONENT16, GL_DEPTH_COMPONENT, GL_UNSIGNED_SHORT, 1, 2},
+        {GL_DEPTH_COMPONENT24, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, 1, 4},
+        {GL_DEPTH_COMPONENT32F, GL_DEPTH_COMPONENT, GL_FLOAT, 1, 4},
+        {GL_DEPTH24_STENCIL8, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, 2, 4},
+    }};
+    for (auto const &format : formats) {
+      if (format.internal_format == internal_format) {
+        return format;
+      }
+    }
+    return {};
+  }
+
   friend class frame_buffer;
+  friend class texture_streamer;
+  texture_2D() : texture(GL_TEXTURE_2D) {}
   GLuint get_id() const { return *texture_id; }
 };
 
+// Layers of equally sized images, so that meshes with different materials
+// can share one texture binding and select their layer instead.
+class texture_2D_array final : public texture {
+public:
+  // the first image decides the format; the others are converted to its
+  // channel count and must have the same size
+  explicit texture_2D_array(const std::vector<std::filesystem::path> &images,
+                            extra_config config = {})
+      : texture(GL_TEXTURE_2D_ARRAY) {
+    if (images.empty()) {
+      throw_exception("no image for texture_2D_array");
+    }
+    if constexpr (opengl::context::gl_minor_version < 5) {
+      if (!bind()) {
+        throw_exception("bind failed");
+      }
+    }
+
+    auto const layer_count = static_cast<GLsizei>(images.size());
+    pixel_format pixel;
+    GLsizei width = 0, height = 0;
+    for (GLsizei layer = 0; layer < layer_count; layer++) {
+      auto decoded = decode_image(images[layer], config, pixel.channels);
+      if (!decoded) {
+        throw_exception("decode_image failed");
+      }
+      if (layer == 0) {
+        pixel = decoded->pixel;
+        width = decoded->width;
+        height = decoded->height;
+      } else if (decoded->width != width || decoded->height != height ||
+                 decoded->pixel.internal_format != pixel.internal_format) {
+        throw_exception(std::string("layer does not match the first image:") +
+                        images[layer].string());
+      }
+
+      glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+      auto const uploaded =
+          upload_image(layer, layer_count, width, height, pixel,
+                       decoded->data.get(), config.generate_mipmap);
+      glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+      if (!uploaded) {
+        throw_exception("upload_image failed");
+      }
+    }
+    *memory_size =
+        static_cast<size_t>(width) * height * pixel.texel_size * layer_count;
+
+    if (!set_grey_swizzle(config.image_usage, pixel.channels)) {
+      throw_exception("set_grey_swizzle failed");
+    }
+    // filtered like texture_2D, so that packing textures into an array does
+    // not change how they look
+    if (!set_parameter(GL_TEXTURE_MIN_FILTER, GL_LINEAR)) {
+      throw_exception("set GL_TEXTURE_MIN_FILTER failed");
+    }
+    if (!set_parameter(GL_TEXTURE_MAG_FILTER, GL_LINEAR)) {
+      throw_exception("set GL_TEXTURE_MAG_FILTER failed");
+    }
+    if (config.generate_mipmap && !generate_mipmap()) {
+      throw_exception("generate_mipmap failed");
+    }
+  }
+
+  texture_2D_array(const texture_2D_array &) = default;
+  texture_2D_array &operator=(const texture_2D_array &) = default;
+
+  texture_2D_array(texture_2D_array &&) noexcept = default;
+  texture_2D_array &operator=(texture_2D_array &&) noexcept = default;
+
+  ~texture_2D_array() override = default;
+};
+
 class texture_cube_map final : public texture {
 public:
   explicit texture_cube_map(std::array<std::filesystem::path, 6> images,
                             extra_config config = {})
       : texture(GL_TEXTURE_CUBE_MAP) {
 
-    if (!bind()) {
-      throw_exception("bind failed");
+    if constexpr (opengl::context::gl_minor_version < 5) {
+      if (!bind()) {
+        throw_exception("bind failed");
+      }
     }
 
     for (size_t i = 0; i < 6; i++) {
-      if (!load_texture_image(images[i], GL_TEXTURE_CUBE_MAP_POSITIVE_X + i,
-                              config)) {
+      if (!load_texture_image(images[i], static_cast<GLint>(i), config)) {
         throw_exception("load_texture_image failed");
       }
     }
@@ -214,11 +632,8 @@ public:
     if (!set_parameter(GL_TEXTURE_MAG_FILTER, GL_LINEAR)) {
       throw_exception("set GL_TEXTURE_MAG_FILTER failed");
     }
-    if (config.generate_mipmap) {
-      glGenerateMipmap(target);
-      if (check_error()) {
-        throw_exception("glGenerateMipmap failed");
-      }
+    if (config.generate_mipmap && !generate_mipmap()) {
+      throw_exception("generate_mipmap failed");
     }
   }
 
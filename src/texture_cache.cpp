@@ -0,0 +1,184 @@
+
+#include <algorithm>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+#include "texture_cache.hpp"
+#include "texture_streamer.hpp"
+
+namespace opengl {
+
+opengl::texture_2D texture_cache::get(const std::filesystem::path &image,
+                                      texture::extra_config config) {
+  std::lock_guard lock(mutex);
+  key_type key{std::filesystem::absolute(image), config};
+  if (auto it = entries.find(key); it != entries.end()) {
+    stats.hits++;
+    auto &e = it->second;
+    e.last_used_frame = current_frame;
+    if (e.texture.residency->evicted) {
+      load_again(it->first, e);
+    }
+    return e.texture;
+  }
+
+  stats.misses++;
+  auto texture = config.streaming
+                     ? texture_streamer::instance().load(key.first, config)
+                     : opengl::texture_2D(key.first, config);
+  texture.residency = std::make_shared<texture_residency>();
+  entries.try_emplace(key, entry{texture, current_frame});
+  evict();
+  return texture;
+}
+
+void texture_cache::set_budget(size_t bytes) {
+  std::lock_guard lock(mutex);
+  budget = bytes;
+  evict();
+}
+
+size_t texture_cache::get_budget() const {
+  std::lock_guard lock(mutex);
+  return budget;
+}
+
+void texture_cache::begin_frame() {
+  std::lock_guard lock(mutex);
+  evict();
+  for (auto it = entries.begin(); it != entries.end();) {
+    auto &e = it->second;
+    if (e.texture.residency->drawn) {
+      e.last_used_frame = current_frame;
+      e.texture.residency->drawn = false;
+    }
+    // nobody can bind an evicted texture the cache alone holds
+    if (e.texture.residency->evicted && !is_shared(e)) {
+      it = entries.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  current_frame++;
+}
+
+bool texture_cache::reload(const texture_residency &residency) noexcept {
+  std::lock_guard lock(mutex);
+  auto it = std::find_if(entries.begin(), entries.end(), [&](auto const &p) {
+    return p.second.texture.residency.get() == &residency;
+  });
+  if (it == entries.end()) {
+    std::cerr << "texture is no longer in the cache" << std::endl;
+    return false;
+  }
+  if (!residency.evicted) {
+    return true;
+  }
+  try {
+    load_again(it->first, it->second);
+  } catch (const std::exception &e) {
+    std::cerr << "reload " << it->first.first << " failed:" << e.what()
+              << std::endl;
+    return false;
+  }
+  return true;
+}
+
+void texture_cache::clear() {
+  std::lock_guard lock(mutex);
+  entries.clear();
+}
+
+texture_cache::statistics texture_cache::get_statistics() const {
+  std::lock_guard lock(mutex);
+  auto result = stats;
+  result.resident_bytes = get_resident_bytes();
+  for (auto const &[_, e] : entries) {
+    if (e.texture.residency->evicted) {
+      result.released_count++;
+    } else {
+      result.resident_count++;
+    }
+  }
+  if (result.resident_bytes > budget) {
+    result.over_budget_bytes = result.resident_bytes - budget;
+  }
+  return result;
+}
+
+// whether a model, a texture set or a caller holds a copy of the texture
+bool texture_cache::is_shared(const entry &e) noexcept {
+  return e.texture.texture_id.use_count() > 1;
+}
+
+bool texture_cache::is_used(const entry &e) const noexcept {
+  return e.last_used_frame == current_frame || e.texture.residency->drawn;
+}
+
+// delete the video memory but keep the entry, which the copies still refer to
+void texture_cache::release(entry &e) noexcept {
+  auto &texture_id = *e.texture.texture_id;
+  glDeleteTextures(1, &texture_id);
+  render_statistics::get_current().objects_deleted++;
+  texture_id = 0;
+  *e.texture.memory_size = 0;
+  e.texture.residency->evicted = true;
+}
+
+// Load the image into a new texture and hand its name to the copies of the
+// evicted one.
+void texture_cache::load_again(const key_type &key, entry &e) {
+  opengl::texture_2D loaded(key.first, key.second);
+  *e.texture.texture_id = std::exchange(*loaded.texture_id, 0);
+  *e.texture.memory_size = *loaded.memory_size;
+  e.texture.residency->evicted = false;
+  stats.reloads++;
+}
+
+// streamed textures change size over time, so this is not kept incrementally
+size_t texture_cache::get_resident_bytes() const noexcept {
+  size_t bytes = 0;
+  for (auto const &[_, e] : entries) {
+    bytes += e.texture.get_memory_size();
+  }
+  return bytes;
+}
+
+void texture_cache::evict() {
+  auto resident_bytes = get_resident_bytes();
+  if (resident_bytes <= budget) {
+    return;
+  }
+
+  std::vector<std::map<key_type, entry>::iterator> candidates;
+  for (auto it = entries.begin(); it != entries.end(); ++it) {
+    auto const &e = it->second;
+    if (!is_used(e) && !e.texture.is_streamed() &&
+        !e.texture.residency->evicted) {
+      candidates.push_back(it);
+    }
+  }
+  std::sort(candidates.begin(), candidates.end(),
+            [](auto const &lhs, auto const &rhs) {
+              return lhs->second.last_used_frame <
+                     rhs->second.last_used_frame;
+            });
+
+  for (auto it : candidates) {
+    if (resident_bytes <= budget) {
+      break;
+    }
+    auto const bytes = it->second.texture.get_memory_size();
+    resident_bytes -= bytes;
+    stats.evictions++;
+    stats.evicted_bytes += bytes;
+    if (is_shared(it->second)) {
+      release(it->second);
+    } else {
+      entries.erase(it);
+    }
+  }
+}
+
+} // namespace opengl
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <utility>
+
+#include "texture.hpp"
+
+namespace opengl {
+
+// Process-wide cache of image textures keyed by path and load config.
+//
+// Whenever the resident size exceeds the budget, textures that were neither
+// requested nor drawn in the current frame are evicted, least recently used
+// first. Textures only the cache holds are dropped. The video memory of
+// textures still held elsewhere, e.g. by a model, is released instead, and a
+// program reloads it when it binds the texture again. Streamed textures are
+// left to texture_streamer and never evicted.
+// Call begin_frame() once per frame and clear() before the context is
+// destroyed.
+class texture_cache final {
+
+public:
+  struct statistics {
+    size_t hits{};
+    size_t misses{};
+    size_t evictions{};
+    size_t evicted_bytes{};
+    size_t resident_bytes{};
+    size_t resident_count{};
+    // evicted textures still held outside the cache
+    size_t released_count{};
+    // evicted textures reloaded because they were bound again
+    size_t reloads{};
+    // how far the resident size exceeds the budget, e.g. because the
+    // textures drawn in one frame alone exceed it
+    size_t over_budget_bytes{};
+  };
+
+public:
+  static texture_cache &instance() {
+    static texture_cache cache;
+    return cache;
+  }
+
+  texture_cache(const texture_cache &) = delete;
+  texture_cache &operator=(const texture_cache &) = delete;
+
+  texture_cache(texture_cache &&) noexcept = delete;
+  texture_cache &operator=(texture_cache &&) noexcept = delete;
+
+  opengl::texture_2D get(const std::filesystem::path &image,
+                         texture::extra_config config = {});
+
+  void set_budget(size_t bytes);
+  size_t get_budget() const;
+
+  // evicts down to the budget what the ending frame did not use, then
+  // starts a new frame
+  void begin_frame();
+
+  // reload the video memory of an evicted texture; called by program when it
+  // binds the texture
+  bool reload(const texture_residency &residency) noexcept;
+
+  // drop every entry, including the ones still referenced elsewhere
+  void clear();
+
+  statistics get_statistics() const;
+
+private:
+  texture_cache() = default;
+  ~texture_cache() noexcept = default;
+
+  using key_type = std::pair<std::filesystem::path, texture::extra_config>;
+
+  struct entry {
+    opengl::texture_2D texture;
+    uint64_t last_used_frame;
+  };
+
+  void evict();
+  size_t get_resident_bytes() const noexcept;
+  bool is_used(const entry &e) const noexcept;
+  static bool is_shared(const entry &e) noexcept;
+  static void release(entry &e) noexcept;
+  void load_again(const key_type &key, entry &e);
+
+private:
+  mutable std::mutex mutex;
+  std::map<key_type, entry> entries;
+  size_t budget{std::numeric_limits<size_t>::max()};
+  uint64_t current_frame{};
+  statistics stats;
+};
+
+} // namespace opengl
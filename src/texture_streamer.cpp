@@ -0,0 +1,412 @@
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+#include "profiler.hpp"
+#include "render_statistics.hpp"
+#include "texture_streamer.hpp"
+
+namespace opengl {
+
+namespace {
+// levels up to this size are uploaded as soon as they are decoded
+constexpr GLsizei coarse_level_size = 64;
+// decoding is bound by memory bandwidth more than by cores
+constexpr size_t decode_thread_count = 2;
+} // namespace
+
+texture_streamer::~texture_streamer() noexcept {
+  {
+    std::lock_guard lock(queue_mutex);
+    stopping = true;
+  }
+  queue_condition.notify_all();
+  for (auto &worker : workers) {
+    worker.join();
+  }
+}
+
+opengl::texture_2D
+texture_streamer::load(const std::filesystem::path &image,
+                       texture::extra_config config) {
+  int width = 0, height = 0, channel = 0;
+  if (!stbi_info(image.string().c_str(), &width, &height, &channel)) {
+    throw_exception(std::string("stbi_info failed:") + image.string());
+  }
+
+  auto const pixel =
+      texture::choose_pixel_format(config.image_usage, channel, false);
+  if (pixel.type != GL_UNSIGNED_BYTE) {
+    throw_exception("only 8-bit images can be streamed");
+  }
+
+  opengl::texture_2D texture;
+  texture.streamed = true;
+
+  job j;
+  j.pixel = pixel;
+  j.width = width;
+  j.height = height;
+  j.level_count =
+      config.generate_mipmap
+          ? static_cast<GLint>(std::log2(std::max(width, height))) + 1
+          : 1;
+  j.base_level = j.level_count;
+
+  if (!texture.bind()) {
+    throw_exception("bind failed");
+  }
+  if (!texture.set_parameter(GL_TEXTURE_MIN_FILTER,
+                             config.generate_mipmap ? GL_LINEAR_MIPMAP_LINEAR
+                                                    : GL_LINEAR)) {
+    throw_exception("set GL_TEXTURE_MIN_FILTER failed");
+  }
+  if (!texture.set_parameter(GL_TEXTURE_MAG_FILTER, GL_LINEAR)) {
+    throw_exception("set GL_TEXTURE_MAG_FILTER failed");
+  }
+  if (!texture.set_parameter(GL_TEXTURE_MAX_LEVEL, j.level_count - 1)) {
+    throw_exception("set GL_TEXTURE_MAX_LEVEL failed");
+  }
+  if (!texture.set_grey_swizzle(config.image_usage, pixel.channels)) {
+    throw_exception("set_grey_swizzle failed");
+  }
+
+  j.image = image;
+  j.flip_y = config.flip_y;
+  j.generate_mipmap = config.generate_mipmap;
+  j.texture_id = texture.texture_id;
+  j.memory_size = texture.memory_size;
+  start_decoding(j);
+
+  std::lock_guard lock(mutex);
+  // the name may belong to a deleted texture that update() has not seen yet
+  jobs.insert_or_assign(texture.get_id(), std::move(j));
+  return texture;
+}
+
+void texture_streamer::report_footprint(const opengl::texture &texture,
+                                        float screen_pixels) {
+  if (!texture.is_streamed()) {
+    return;
+  }
+  std::lock_guard lock(mutex);
+  auto it = jobs.find(*texture.texture_id);
+  if (it == jobs.end()) {
+    return;
+  }
+  it->second.footprint = std::max(it->second.footprint, screen_pixels);
+  it->second.last_visible_frame = current_frame;
+}
+
+void texture_streamer::update(size_t upload_budget_bytes) {
+  opengl::profiler::zone zone("texture_streamer::update");
+  std::lock_guard lock(mutex);
+  current_frame++;
+
+  std::vector<job *> candidates;
+  for (auto it = jobs.begin(); it != jobs.end();) {
+    auto &j = it->second;
+    if (j.texture_id.expired()) {
+      it = jobs.erase(it);
+      continue;
+    }
+    if (j.decoding.valid()) {
+      if (j.decoding.wait_for(std::chrono::seconds(0)) !=
+          std::future_status::ready) {
+        ++it;
+        continue;
+      }
+      try {
+        j.chain = j.decoding.get();
+      } catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        it = jobs.erase(it);
+        continue;
+      }
+      // a decode for streaming levels back in also holds the resident ones
+      for (auto level = j.base_level; level < j.level_count; level++) {
+        if (static_cast<size_t>(level) < j.chain.levels.size()) {
+          std::vector<stbi_uc>().swap(j.chain.levels[level]);
+        }
+      }
+    }
+
+    GLint coarse_level = 0;
+    while (coarse_level + 1 < j.level_count &&
+           std::max(j.width >> coarse_level, j.height >> coarse_level) >
+               coarse_level_size) {
+      coarse_level++;
+    }
+    auto const wanted = std::min(wanted_level(j), coarse_level);
+    if (j.base_level > wanted && !has_level(j, j.base_level - 1)) {
+      // the pixels were dropped after an earlier upload
+      start_decoding(j);
+      ++it;
+      continue;
+    }
+    while (j.base_level > coarse_level) {
+      if (!upload_level(j, j.base_level - 1)) {
+        break;
+      }
+    }
+
+    if (j.base_level > wanted) {
+      candidates.push_back(&j);
+    } else if (wanted >= j.base_level + 2 ||
+               (wanted > j.base_level &&
+                current_frame - j.last_visible_frame > release_delay)) {
+      // keep one level of hysteresis while the texture is on screen
+      release_levels(j, wanted);
+    }
+    ++it;
+  }
+
+  std::sort(candidates.begin(), candidates.end(),
+            [](auto const *lhs, auto const *rhs) {
+              return lhs->footprint > rhs->footprint;
+            });
+
+  // one level per texture and pass, so that the budget is shared in order of
+  // priority
+  size_t uploaded = 0;
+  bool progress = true;
+  while (progress && uploaded < upload_budget_bytes) {
+    progress = false;
+    for (auto *j : candidates) {
+      if (j->base_level <= wanted_level(*j)) {
+        continue;
+      }
+      auto const bytes = level_bytes(*j, j->base_level - 1);
+      if (uploaded != 0 && uploaded + bytes > upload_budget_bytes) {
+        continue;
+      }
+      if (!upload_level(*j, j->base_level - 1)) {
+        continue;
+      }
+      uploaded += bytes;
+      progress = true;
+    }
+  }
+
+  for (auto &[_, j] : jobs) {
+    j.footprint = 0;
+  }
+}
+
+void texture_streamer::set_release_delay(uint64_t frames) {
+  std::lock_guard lock(mutex);
+  release_delay = frames;
+}
+
+texture_streamer::statistics texture_streamer::get_statistics() const {
+  std::lock_guard lock(mutex);
+  auto result = stats;
+  result.streamed_textures = jobs.size();
+  result.resident_bytes = 0;
+  result.cpu_bytes = 0;
+  for (auto const &[_, j] : jobs) {
+    result.resident_bytes += *j.memory_size;
+    for (auto const &level : j.chain.levels) {
+      result.cpu_bytes += level.size();
+    }
+  }
+  return result;
+}
+
+void texture_streamer::clear() {
+  std::lock_guard lock(mutex);
+  jobs.clear();
+  std::lock_guard queue_lock(queue_mutex);
+  decode_queue.clear();
+}
+
+void texture_streamer::start_decoding(job &j) {
+  std::packaged_task<mip_chain()> task(
+      [image = j.image, channels = j.pixel.channels, flip_y = j.flip_y,
+       generate_mipmap = j.generate_mipmap] {
+        return decode(image, channels, flip_y, generate_mipmap);
+      });
+  j.decoding = task.get_future();
+  {
+    std::lock_guard lock(queue_mutex);
+    decode_queue.push_back(std::move(task));
+    if (workers.empty()) {
+      for (size_t i = 0; i < decode_thread_count; i++) {
+        workers.emplace_back([this] { run_worker(); });
+      }
+    }
+  }
+  queue_condition.notify_one();
+}
+
+void texture_streamer::run_worker() {
+  for (;;) {
+    std::packaged_task<mip_chain()> task;
+    {
+      std::unique_lock lock(queue_mutex);
+      queue_condition.wait(
+          lock, [this] { return stopping || !decode_queue.empty(); });
+      if (stopping) {
+        return;
+      }
+      task = std::move(decode_queue.front());
+      decode_queue.pop_front();
+    }
+    // exceptions end up in the future
+    task();
+  }
+}
+
+bool texture_streamer::has_level(const job &j, GLint level) noexcept {
+  return static_cast<size_t>(level) < j.chain.levels.size() &&
+         !j.chain.levels[level].empty();
+}
+
+texture_streamer::mip_chain
+texture_streamer::decode(std::filesystem::path image, int channels,
+                         bool flip_y, bool generate_mipmap) {
+  // the global flag belongs to the loading thread
+  stbi_set_flip_vertically_on_load_thread(flip_y);
+
+  int width = 0, height = 0, channel = 0;
+  auto *data =
+      stbi_load(image.string().c_str(), &width, &height, &channel, channels);
+  if (!data) {
+    throw std::runtime_error(std::string("stbi_load failed:") +
+                             image.string());
+  }
+  auto cleanup = gsl::finally([data]() { stbi_image_free(data); });
+
+  mip_chain chain;
+  chain.width = width;
+  chain.height = height;
+  chain.levels.emplace_back(data, data + static_cast<size_t>(width) * height *
+                                             channels);
+
+  // 2x2 box filter, clamping at odd edges
+  while (generate_mipmap && (width > 1 || height > 1)) {
+    auto const &src = chain.levels.back();
+    auto const next_width = std::max(width / 2, 1);
+    auto const next_height = std::max(height / 2, 1);
+    std::vector<stbi_uc> dst(static_cast<size_t>(next_width) * next_height *
+                             channels);
+    for (int y = 0; y < next_height; y++) {
+      auto const y0 = std::min(y * 2, height - 1);
+      auto const y1 = std::min(y * 2 + 1, height - 1);
+      for (int x = 0; x < next_width; x++) {
+        auto const x0 = std::min(x * 2, width - 1);
+        auto const x1 = std::min(x * 2 + 1, width - 1);
+        for (int c = 0; c < channels; c++) {
+          auto texel = [&](int tx, int ty) {
+            return static_cast<unsigned>(
+                src[(static_cast<size_t>(ty) * width + tx) * channels + c]);
+          };
+          dst[(static_cast<size_t>(y) * next_width + x) * channels + c] =
+              static_cast<stbi_uc>((texel(x0, y0) + texel(x1, y0) +
+                                    texel(x0, y1) + texel(x1, y1) + 2) /
+                                   4);
+        }
+      }
+    }
+    chain.levels.emplace_back(std::move(dst));
+    width = next_width;
+    height = next_height;
+  }
+  return chain;
+}
+
+size_t texture_streamer::level_bytes(const job &j, GLint level) noexcept {
+  return static_cast<size_t>(std::max(j.width >> level, 1)) *
+         std::max(j.height >> level, 1) * j.pixel.texel_size;
+}
+
+GLint texture_streamer::wanted_level(const job &j) const noexcept {
+  if (j.footprint <= 0) {
+    // off screen: keep what is resident until the release delay has passed
+    if (current_frame - j.last_visible_frame > release_delay) {
+      return j.level_count - 1;
+    }
+    return std::min(j.base_level, j.level_count - 1);
+  }
+  auto const size = static_cast<float>(std::max(j.width, j.height));
+  auto const level = static_cast<GLint>(
+      std::floor(std::log2(std::max(size / j.footprint, 1.0f))));
+  return std::min(level, j.level_count - 1);
+}
+
+bool texture_streamer::upload_level(job &j, GLint level) {
+  if (!has_level(j, level)) {
+    return false;
+  }
+  auto id = j.texture_id.lock();
+  if (!id) {
+    return false;
+  }
+
+  glBindTexture(GL_TEXTURE_2D, *id);
+  if (check_error()) {
+    std::cerr << "glBindTexture failed" << std::endl;
+    return false;
+  }
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  glTexImage2D(GL_TEXTURE_2D, level, j.pixel.internal_format,
+               std::max(j.width >> level, 1), std::max(j.height >> level, 1),
+               0, j.pixel.format, j.pixel.type, j.chain.levels[level].data());
+  auto const failed = check_error();
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+  if (failed) {
+    std::cerr << "glTexImage2D failed" << std::endl;
+    return false;
+  }
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level);
+  if (check_error()) {
+    std::cerr << "set GL_TEXTURE_BASE_LEVEL failed" << std::endl;
+    return false;
+  }
+
+  auto const bytes = level_bytes(j, level);
+  render_statistics::get_current().texture_uploaded_bytes += bytes;
+  // the level is decoded again if it is released and wanted back
+  std::vector<stbi_uc>().swap(j.chain.levels[level]);
+  j.base_level = level;
+  *j.memory_size += bytes;
+  stats.uploaded_bytes += bytes;
+  return true;
+}
+
+bool texture_streamer::release_levels(job &j, GLint new_base_level) {
+  auto id = j.texture_id.lock();
+  if (!id) {
+    return false;
+  }
+
+  glBindTexture(GL_TEXTURE_2D, *id);
+  if (check_error()) {
+    std::cerr << "glBindTexture failed" << std::endl;
+    return false;
+  }
+  // raise the base level first so that the texture stays complete
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, new_base_level);
+  if (check_error()) {
+    std::cerr << "set GL_TEXTURE_BASE_LEVEL failed" << std::endl;
+    return false;
+  }
+  for (auto level = j.base_level; level < new_base_level; level++) {
+    // a zero-sized image gives the level's memory back
+    glTexImage2D(GL_TEXTURE_2D, level, j.pixel.internal_format, 0, 0, 0,
+                 j.pixel.format, j.pixel.type, nullptr);
+    if (check_error()) {
+      std::cerr << "glTexImage2D failed" << std::endl;
+      return false;
+    }
+    auto const bytes = level_bytes(j, level);
+    *j.memory_size -= bytes;
+    stats.released_bytes += bytes;
+  }
+  j.base_level = new_base_level;
+  return true;
+}
+
+} // namespace opengl
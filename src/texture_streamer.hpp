@@ -0,0 +1,126 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "texture.hpp"
+
+namespace opengl {
+
+// Streams the mip levels of 2D textures in, coarsest first.
+//
+// Images are decoded and their mip chains built by a small pool of worker
+// threads. update() uploads the pending levels on the GL thread, giving
+// priority to the textures with the largest on-screen footprint as reported by
+// the draw path, and moves GL_TEXTURE_BASE_LEVEL down as finer levels become
+// resident. The decoded pixels of a level are dropped once it is uploaded.
+// Fine levels of textures that stay off screen are released again, and the
+// image is decoded anew when they are wanted back.
+class texture_streamer final {
+
+public:
+  struct statistics {
+    size_t streamed_textures{};
+    size_t resident_bytes{};
+    size_t uploaded_bytes{};
+    size_t released_bytes{};
+    // decoded pixels waiting in system memory for their upload
+    size_t cpu_bytes{};
+  };
+
+public:
+  static texture_streamer &instance() {
+    static texture_streamer streamer;
+    return streamer;
+  }
+
+  texture_streamer(const texture_streamer &) = delete;
+  texture_streamer &operator=(const texture_streamer &) = delete;
+
+  texture_streamer(texture_streamer &&) noexcept = delete;
+  texture_streamer &operator=(texture_streamer &&) noexcept = delete;
+
+  // returns immediately; the texture samples as black until its first levels
+  // are uploaded by update()
+  opengl::texture_2D load(const std::filesystem::path &image,
+                          texture::extra_config config = {});
+
+  // screen_pixels is the on-screen extent of the surface the texture is
+  // mapped to in the current frame
+  void report_footprint(const opengl::texture &texture, float screen_pixels);
+
+  // call once per frame with a current context
+  void update(size_t upload_budget_bytes = 4 << 20);
+
+  // number of frames a texture may stay off screen before its fine levels are
+  // released
+  void set_release_delay(uint64_t frames);
+
+  statistics get_statistics() const;
+
+  // drop every pending job; call before the context is destroyed
+  void clear();
+
+private:
+  texture_streamer() = default;
+  ~texture_streamer() noexcept;
+
+  struct mip_chain {
+    GLsizei width{};
+    GLsizei height{};
+    // 8-bit pixels of every level, finest first; empty once uploaded
+    std::vector<std::vector<stbi_uc>> levels;
+  };
+
+  struct job {
+    std::filesystem::path image;
+    bool flip_y{};
+    bool generate_mipmap{};
+    std::weak_ptr<GLuint> texture_id;
+    std::shared_ptr<size_t> memory_size;
+    texture::pixel_format pixel;
+    GLsizei width{};
+    GLsizei height{};
+    GLint level_count{};
+    // finest resident level; level_count while nothing is resident
+    GLint base_level{};
+    std::future<mip_chain> decoding;
+    mip_chain chain;
+    float footprint{};
+    uint64_t last_visible_frame{};
+  };
+
+  static mip_chain decode(std::filesystem::path image, int channels,
+                          bool flip_y, bool generate_mipmap);
+  // queues j's image for the worker threads
+  void start_decoding(job &j);
+  void run_worker();
+  static bool has_level(const job &j, GLint level) noexcept;
+  static size_t level_bytes(const job &j, GLint level) noexcept;
+  GLint wanted_level(const job &j) const noexcept;
+  bool upload_level(job &j, GLint level);
+  bool release_levels(job &j, GLint new_base_level);
+
+private:
+  mutable std::mutex mutex;
+  std::map<GLuint, job> jobs;
+  uint64_t current_frame{};
+  uint64_t release_delay{120};
+  statistics stats;
+
+  std::mutex queue_mutex;
+  std::condition_variable queue_condition;
+  std::deque<std::packaged_task<mip_chain()>> decode_queue;
+  std::vector<std::thread> workers;
+  bool stopping{false};
+};
+
+} // namespace opengl
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+
+#include "context.hpp"
+
+namespace opengl::trace {
+
+// The commands a trace holds and how each argument is stored.
+//
+// Every command is written as its id followed by its arguments in order, with
+// the names it creates and its result after them. The argument roles are
+//   '.'  a plain value
+//   'b' 't' 'v' 'f' 'r' 's'
+//        a buffer, texture, vertex array, framebuffer, renderbuffer or
+//        sampler name
+//   'p'  a program or shader name
+//   'l'  a uniform location of the program argument, or of the program in
+//        use for glUniform*
+//   'k'  a uniform block index, 'K' a shader storage block index
+//   'n'  the number of names or strings in a later 'I', 'O' or 'S' argument
+//   'I'  names going in, 'O' names created; their kind is the command's kind
+//   'd'  data whose size depends on the other arguments
+//   'z'  a NUL-terminated string
+//   'S'  an array of strings with 'x' their lengths, as for glShaderSource
+//   'o'  an offset into a bound buffer passed as a pointer
+// and the result role is one of '.', 'p', 'l', 'k' and 'K'.
+//
+// Only the commands the wrappers issue are listed: those of the OpenGL 4.5
+// path, the classic texture commands texture_streamer allocates and releases
+// single mip levels with, and the binding commands of the pre-4.5 path, along
+// with the usual per-frame state commands an application issues itself.
+
+// X(command, kind, result role, argument roles)
+#define OPENGL_TRACE_COMMANDS(X)                                               \
+  X(CreateBuffers, 'b', '.', "nO")                                             \
+  X(CreateTextures, 't', '.', ".nO")                                           \
+  X(CreateVertexArrays, 'v', '.', "nO")                                        \
+  X(CreateFramebuffers, 'f', '.', "nO")                                        \
+  X(CreateRenderbuffers, 'r', '.', "nO")                                       \
+  X(CreateSamplers, 's', '.', "nO")                                            \
+  X(CreateProgram, '.', 'p', "")                                               \
+  X(CreateShader, '.', 'p', ".")                                               \
+  X(DeleteBuffers, 'b', '.', "nI")                                             \
+  X(DeleteTextures, 't', '.', "nI")                                            \
+  X(DeleteVertexArrays, 'v', '.', "nI")                                        \
+  X(DeleteFramebuffers, 'f', '.', "nI")                                        \
+  X(DeleteRenderbuffers, 'r', '.', "nI")                                       \
+  X(DeleteSamplers, 's', '.', "nI")                                            \
+  X(DeleteProgram, '.', '.', "p")                                              \
+  X(DeleteShader, '.', '.', "p")                                               \
+  X(NamedBufferData, '.', '.', "b.d.")                                         \
+  X(NamedBufferSubData, '.', '.', "b..d")                                      \
+  X(BindBufferBase, '.', '.', "..b")                                           \
+  X(BindBufferRange, '.', '.', "..b..")                                        \
+  X(TextureStorage2D, '.', '.', "t....")                                       \
+  X(TextureStorage3D, '.', '.', "t.....")                                      \
+  X(TextureSubImage2D, '.', '.', "t.......d")                                  \
+  X(TextureSubImage3D, '.', '.', "t.........d")                                \
+  X(TexImage2D, '.', '.', "........d")                                         \
+  X(TextureParameteri, '.', '.', "t..")                                        \
+  X(TextureParameterf, '.', '.', "t..")                                        \
+  X(TextureParameteriv, '.', '.', "t.d")                                       \
+  X(TexParameteri, '.', '.', "...")                                            \
+  X(GenerateTextureMipmap, '.', '.', "t")                                      \
+  X(BindTextureUnit, '.', '.', ".t")                                           \
+  X(ActiveTexture, '.', '.', ".")                                              \
+  X(BindTexture, '.', '.', ".t")                                               \
+  X(BindTextures, 't', '.', ".nI")                                             \
+  X(BindSamplers, 's', '.', ".nI")                                             \
+  X(BindSampler, '.', '.', ".s")                                               \
+  X(SamplerParameteri, '.', '.', "s..")                                        \
+  X(PixelStorei, '.', '.', "..")                                               \
+  X(EnableVertexArrayAttrib, '.', '.', "v.")                                   \
+  X(VertexArrayAttribFormat, '.', '.', "v.....")                               \
+  X(VertexArrayAttribBinding, '.', '.', "v..")                                 \
+  X(VertexArrayVertexBuffer, '.', '.', "v.b..")                                \
+  X(VertexArrayElementBuffer, '.', '.', "vb")                                  \
+  X(VertexArrayBindingDivisor, '.', '.', "v..")                                \
+  X(BindVertexArray, '.', '.', "v")                                            \
+  X(NamedFramebufferTexture, '.', '.', "f.t.")                                 \
+  X(NamedFramebufferRenderbuffer, '.', '.', "f..r")                            \
+  X(NamedRenderbufferStorage, '.', '.', "r...")                                \
+  X(BindFramebuffer, '.', '.', ".f")                                           \
+  X(ShaderSource, '.', '.', "pnSx")                                            \
+  X(CompileShader, '.', '.', "p")                                              \
+  X(AttachShader, '.', '.', "pp")                                              \
+  X(DetachShader, '.', '.', "pp")                                              \
+  X(LinkProgram, '.', '.', "p")                                                \
+  X(UseProgram, '.', '.', "p")                                                 \
+  X(GetUniformLocation, '.', 'l', "pz")                                        \
+  X(GetUniformBlockIndex, '.', 'k', "pz")                                      \
+  X(GetProgramResourceIndex, '.', 'K', "p.z")                                  \
+  X(UniformBlockBinding, '.', '.', "pk.")                                      \
+  X(ShaderStorageBlockBinding, '.', '.', "pK.")                                \
+  X(ProgramUniform1iv, '.', '.', "pl.d")                                       \
+  X(ProgramUniform1uiv, '.', '.', "pl.d")                                      \
+  X(ProgramUniform1fv, '.', '.', "pl.d")                                       \
+  X(ProgramUniform2fv, '.', '.', "pl.d")                                       \
+  X(ProgramUniform3fv, '.', '.', "pl.d")                                       \
+  X(ProgramUniform4fv, '.', '.', "pl.d")                                       \
+  X(ProgramUniformMatrix3fv, '.', '.', "pl..d")                                \
+  X(ProgramUniformMatrix4fv, '.', '.', "pl..d")                                \
+  X(Uniform1i, '.', '.', "l.")                                                 \
+  X(Uniform1f, '.', '.', "l.")                                                 \
+  X(Uniform3i, '.', '.', "l...")                                               \
+  X(Uniform3f, '.', '.', "l...")                                               \
+  X(Uniform3fv, '.', '.', "l.d")                                               \
+  X(UniformMatrix4fv, '.', '.', "l..d")                                        \
+  X(Enable, '.', '.', ".")                                                     \
+  X(Disable, '.', '.', ".")                                                    \
+  X(Viewport, '.', '.', "....")                                                \
+  X(Clear, '.', '.', ".")                                                      \
+  X(ClearColor, '.', '.', "....")                                              \
+  X(DepthFunc, '.', '.', ".")                                                  \
+  X(DepthMask, '.', '.', ".")                                                  \
+  X(BlendFunc, '.', '.', "..")                                                 \
+  X(CullFace, '.', '.', ".")                                                   \
+  X(DrawElements, '.', '.', "...o")                                            \
+  X(DrawElementsInstancedBaseInstance, '.', '.', "...o..")
+
+enum class command : uint16_t {
+#define OPENGL_TRACE_ENUM(name, kind, result, roles) name,
+  OPENGL_TRACE_COMMANDS(OPENGL_TRACE_ENUM)
+#undef OPENGL_TRACE_ENUM
+  // not a GL command; written by trace_recorder::end_frame()
+  end_frame
+};
+
+template <command c> struct command_info;
+
+#define OPENGL_TRACE_INFO(name, kind_, result_, roles_)                        \
+  template <> struct command_info<command::name> {                             \
+    static constexpr auto slot = &glad_gl##name;                               \
+    static constexpr char kind = kind_;                                        \
+    static constexpr char result = result_;                                    \
+    static constexpr std::string_view roles = roles_;                          \
+  };
+OPENGL_TRACE_COMMANDS(OPENGL_TRACE_INFO)
+#undef OPENGL_TRACE_INFO
+
+template <command c>
+using command_constant = std::integral_constant<command, c>;
+
+// calls f(command_constant<c>{}) for every command
+template <typename F> void for_each_command(F &&f) {
+#define OPENGL_TRACE_VISIT(name, kind, result, roles)                          \
+  f(command_constant<command::name>{});
+  OPENGL_TRACE_COMMANDS(OPENGL_TRACE_VISIT)
+#undef OPENGL_TRACE_VISIT
+}
+
+// "GLTR" in the first four bytes of a trace
+constexpr uint32_t file_magic = 0x52544c47;
+// bumped whenever the command list or the encoding changes
+constexpr uint32_t file_version = 2;
+// the size written for a null data pointer
+constexpr uint64_t null_payload = ~uint64_t(0);
+// payloads start at multiples of this in the file
+constexpr size_t payload_alignment = 8;
+
+} // namespace opengl::trace
@@ -0,0 +1,361 @@
+
+#include <cstring>
+#include <iostream>
+#include <tuple>
+#include <utility>
+
+#include "trace_commands.hpp"
+#include "trace_recorder.hpp"
+
+namespace opengl {
+
+namespace {
+constexpr size_t flush_threshold = 1 << 20;
+
+// bytes per element of the uniform commands with a 'd' argument
+constexpr size_t uniform_element_size(trace::command c) noexcept {
+  switch (c) {
+  case trace::command::ProgramUniform2fv:
+    return 2 * sizeof(GLfloat);
+  case trace::command::ProgramUniform3fv:
+  case trace::command::Uniform3fv:
+    return 3 * sizeof(GLfloat);
+  case trace::command::ProgramUniform4fv:
+    return 4 * sizeof(GLfloat);
+  case trace::command::ProgramUniformMatrix3fv:
+    return 9 * sizeof(GLfloat);
+  case trace::command::ProgramUniformMatrix4fv:
+  case trace::command::UniformMatrix4fv:
+    return 16 * sizeof(GLfloat);
+  default:
+    return 4;
+  }
+}
+} // namespace
+
+struct trace_recorder::hooks {
+  template <trace::command c>
+  using function_type =
+      std::remove_pointer_t<decltype(trace::command_info<c>::slot)>;
+
+  // the entry points replaced while recording
+  template <trace::command c> static inline function_type<c> original{};
+
+  static void install() {
+    trace::for_each_command([](auto id) {
+      constexpr auto c = decltype(id)::value;
+      auto const slot = trace::command_info<c>::slot;
+      if (*slot != nullptr) {
+        original<c> = *slot;
+        *slot = &hook<c, function_type<c>>::call;
+      }
+    });
+  }
+
+  static void uninstall() {
+    trace::for_each_command([](auto id) {
+      constexpr auto c = decltype(id)::value;
+      if (original<c> != nullptr) {
+        *trace::command_info<c>::slot = original<c>;
+        original<c> = nullptr;
+      }
+    });
+  }
+
+  template <trace::command c, typename F> struct hook;
+
+  template <trace::command c, typename R, typename... A>
+  struct hook<c, R(APIENTRYP)(A...)> {
+    static_assert(trace::command_info<c>::roles.size() == sizeof...(A),
+                  "one role per argument");
+
+    static R APIENTRY call(A... args) {
+      auto &recorder = instance();
+      std::tuple<A...> const arguments{args...};
+      recorder.write(c);
+      write_arguments<c>(recorder, arguments, std::index_sequence_for<A...>{});
+      if constexpr (c == trace::command::PixelStorei) {
+        recorder.track_pixel_store(args...);
+      }
+      if constexpr (std::is_void_v<R>) {
+        original<c>(args...);
+        write_outputs<c>(recorder, arguments);
+      } else {
+        auto const result = original<c>(args...);
+        write_outputs<c>(recorder, arguments);
+        recorder.write(result);
+        return result;
+      }
+    }
+  };
+
+  template <trace::command c, typename tuple_type>
+  static size_t name_count(const tuple_type &arguments) {
+    constexpr auto index = trace::command_info<c>::roles.find('n');
+    return static_cast<size_t>(std::get<index>(arguments));
+  }
+
+  template <trace::command c, typename tuple_type>
+  static size_t data_size(const trace_recorder &recorder,
+                          const tuple_type &arguments) {
+    using trace::command;
+    if constexpr (c == command::NamedBufferData) {
+      return static_cast<size_t>(std::get<1>(arguments));
+    } else if constexpr (c == command::NamedBufferSubData) {
+      return static_cast<size_t>(std::get<2>(arguments));
+    } else if constexpr (c == command::TextureSubImage2D) {
+      return recorder.image_size(std::get<4>(arguments), std::get<5>(arguments),
+                                 1, std::get<6>(arguments),
+                                 std::get<7>(arguments));
+    } else if constexpr (c == command::TexImage2D) {
+      return recorder.image_size(std::get<3>(arguments), std::get<4>(arguments),
+                                 1, std::get<6>(arguments),
+                                 std::get<7>(arguments));
+    } else if constexpr (c == command::TextureSubImage3D) {
+      return recorder.image_size(std::get<5>(arguments), std::get<6>(arguments),
+                                 std::get<7>(arguments), std::get<8>(arguments),
+                                 std::get<9>(arguments));
+    } else if constexpr (c == command::TextureParameteriv) {
+      auto const pname = std::get<1>(arguments);
+      auto const count = pname == GL_TEXTURE_SWIZZLE_RGBA ||
+                                 pname == GL_TEXTURE_BORDER_COLOR
+                             ? 4
+                             : 1;
+      return count * sizeof(GLint);
+    } else {
+      // the uniform arrays; the element count comes right after the location
+      constexpr auto index = trace::command_info<c>::roles.find('l') + 1;
+      return static_cast<size_t>(std::get<index>(arguments)) *
+             uniform_element_size(c);
+    }
+  }
+
+  template <trace::command c, typename tuple_type, size_t... I>
+  static void write_arguments(trace_recorder &recorder,
+                              const tuple_type &arguments,
+                              std::index_sequence<I...>) {
+    (write_argument<c, I>(recorder, arguments), ...);
+  }
+
+  template <trace::command c, size_t I, typename tuple_type>
+  static void write_argument(trace_recorder &recorder,
+                             const tuple_type &arguments) {
+    constexpr char role = trace::command_info<c>::roles[I];
+    auto const value = std::get<I>(arguments);
+    using value_type = std::remove_const_t<decltype(value)>;
+
+    if constexpr (role == 'O' || role == 'x') {
+      // written after the call, or implied by the 'S' argument
+    } else if constexpr (role == 'I') {
+      recorder.write_payload(value, name_count<c>(arguments) * sizeof(GLuint));
+    } else if constexpr (role == 'd') {
+      recorder.write_payload(value, data_size<c>(recorder, arguments));
+    } else if constexpr (role == 'z') {
+      recorder.write_payload(value, value ? std::strlen(value) + 1 : 0);
+    } else if constexpr (role == 'S') {
+      auto const lengths = std::get<I + 1>(arguments);
+      for (size_t i = 0; i < name_count<c>(arguments); i++) {
+        auto const length = lengths && lengths[i] >= 0
+                                ? static_cast<size_t>(lengths[i])
+                                : std::strlen(value[i]);
+        recorder.write_payload(value[i], length);
+      }
+    } else if constexpr (role == 'o') {
+      recorder.write(
+          static_cast<uint64_t>(reinterpret_cast<uintptr_t>(value)));
+    } else {
+      static_assert(!std::is_pointer_v<value_type>,
+                    "pointer arguments need a role");
+      recorder.write(value);
+    }
+  }
+
+  template <trace::command c, typename tuple_type>
+  static void write_outputs(trace_recorder &recorder,
+                            const tuple_type &arguments) {
+    constexpr auto index = trace::command_info<c>::roles.find('O');
+    if constexpr (index != std::string_view::npos) {
+      recorder.write_bytes(std::get<index>(arguments),
+                           name_count<c>(arguments) * sizeof(GLuint));
+    }
+  }
+};
+
+trace_recorder::~trace_recorder() noexcept {
+  if (recording) {
+    stop();
+  }
+}
+
+bool trace_recorder::start(const std::filesystem::path &trace_file) {
+  if (recording) {
+    std::cerr << "already recording a trace" << std::endl;
+    return false;
+  }
+  out.open(trace_file, std::ios::binary | std::ios::trunc);
+  if (!out) {
+    std::cerr << "open " << trace_file << " failed" << std::endl;
+    return false;
+  }
+  write_failed = false;
+  written_bytes = 0;
+  unpack_alignment = 4;
+  unpack_row_length = 0;
+  write(trace::file_magic);
+  write(trace::file_version);
+
+  hooks::install();
+  recording = true;
+  return true;
+}
+
+bool trace_recorder::stop() {
+  if (!recording) {
+    std::cerr << "no trace is being recorded" << std::endl;
+    return false;
+  }
+  hooks::uninstall();
+  recording = false;
+  flush_buffer();
+  out.close();
+  if (write_failed || !out) {
+    std::cerr << "write trace failed" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+void trace_recorder::end_frame() {
+  if (!recording) {
+    return;
+  }
+  write(trace::command::end_frame);
+  if (buffer.size() >= flush_threshold) {
+    flush_buffer();
+  }
+}
+
+void trace_recorder::write_bytes(const void *data, size_t size) {
+  auto const bytes = static_cast<const std::byte *>(data);
+  buffer.insert(buffer.end(), bytes, bytes + size);
+  written_bytes += size;
+  if (buffer.size() >= 4 * flush_threshold) {
+    flush_buffer();
+  }
+}
+
+void trace_recorder::write_payload(const void *data, size_t size) {
+  if (data == nullptr) {
+    write(trace::null_payload);
+    return;
+  }
+  write(static_cast<uint64_t>(size));
+  // keep the payloads aligned for the replayer, which passes them in place
+  while (written_bytes % trace::payload_alignment != 0) {
+    write(std::byte{0});
+  }
+  write_bytes(data, size);
+}
+
+void trace_recorder::flush_buffer() {
+  if (buffer.empty() || write_failed) {
+    buffer.clear();
+    return;
+  }
+  out.write(reinterpret_cast<const char *>(buffer.data()),
+            static_cast<std::streamsize>(buffer.size()));
+  if (!out) {
+    std::cerr << "write trace failed" << std::endl;
+    write_failed = true;
+  }
+  buffer.clear();
+}
+
+size_t trace_recorder::image_size(GLsizei width, GLsizei height,
+                                  GLsizei depth, GLenum format,
+                                  GLenum type) const {
+  size_t components = 0;
+  switch (format) {
+  case GL_RED:
+  case GL_GREEN:
+  case GL_BLUE:
+  case GL_RED_INTEGER:
+  case GL_DEPTH_COMPONENT:
+  case GL_STENCIL_INDEX:
+    components = 1;
+    break;
+  case GL_RG:
+  case GL_RG_INTEGER:
+  case GL_DEPTH_STENCIL:
+    components = 2;
+    break;
+  case GL_RGB:
+  case GL_BGR:
+  case GL_RGB_INTEGER:
+    components = 3;
+    break;
+  case GL_RGBA:
+  case GL_BGRA:
+  case GL_RGBA_INTEGER:
+    components = 4;
+    break;
+  }
+
+  size_t pixel_size = 0;
+  switch (type) {
+  case GL_UNSIGNED_BYTE:
+  case GL_BYTE:
+    pixel_size = components;
+    break;
+  case GL_UNSIGNED_SHORT:
+  case GL_SHORT:
+  case GL_HALF_FLOAT:
+    pixel_size = 2 * components;
+    break;
+  case GL_UNSIGNED_INT:
+  case GL_INT:
+  case GL_FLOAT:
+    pixel_size = 4 * components;
+    break;
+  case GL_UNSIGNED_SHORT_5_6_5:
+  case GL_UNSIGNED_SHORT_4_4_4_4:
+  case GL_UNSIGNED_SHORT_5_5_5_1:
+    pixel_size = 2;
+    break;
+  case GL_UNSIGNED_INT_8_8_8_8:
+  case GL_UNSIGNED_INT_8_8_8_8_REV:
+  case GL_UNSIGNED_INT_2_10_10_10_REV:
+  case GL_UNSIGNED_INT_10F_11F_11F_REV:
+  case GL_UNSIGNED_INT_24_8:
+    pixel_size = 4;
+    break;
+  }
+  if (components == 0 || pixel_size == 0) {
+    std::cerr << "unsupported pixel format in trace:" << format << ' ' << type
+              << std::endl;
+    return 0;
+  }
+  if (width <= 0 || height <= 0 || depth <= 0) {
+    return 0;
+  }
+
+  auto const row_pixels = static_cast<size_t>(
+      unpack_row_length > 0 ? unpack_row_length : width);
+  auto const alignment = static_cast<size_t>(unpack_alignment);
+  auto const row_stride =
+      (row_pixels * pixel_size + alignment - 1) / alignment * alignment;
+  // the last row is not padded
+  return (static_cast<size_t>(depth) * static_cast<size_t>(height) - 1) *
+             row_stride +
+         static_cast<size_t>(width) * pixel_size;
+}
+
+void trace_recorder::track_pixel_store(GLenum pname, GLint param) noexcept {
+  if (pname == GL_UNPACK_ALIGNMENT) {
+    unpack_alignment = param;
+  } else if (pname == GL_UNPACK_ROW_LENGTH) {
+    unpack_row_length = param;
+  }
+}
+
+} // namespace opengl
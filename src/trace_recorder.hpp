@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+#include "context.hpp"
+
+namespace opengl {
+
+// Captures the GL commands issued through the wrappers into a binary trace
+// that trace_replayer plays back.
+//
+// While recording, the GL entry points listed in trace_commands.hpp are
+// redirected to hooks that write each command and the data it reads, e.g.
+// buffer contents, texel rows and shader sources, before forwarding the call.
+// Object names, uniform locations and block indices are written as the
+// recording driver returned them and mapped again at replay. Start recording
+// before the objects the captured frames use are created, and use it on the GL
+// thread only.
+class trace_recorder final {
+
+public:
+  static trace_recorder &instance() {
+    static trace_recorder recorder;
+    return recorder;
+  }
+
+  trace_recorder(const trace_recorder &) = delete;
+  trace_recorder &operator=(const trace_recorder &) = delete;
+
+  trace_recorder(trace_recorder &&) noexcept = delete;
+  trace_recorder &operator=(trace_recorder &&) noexcept = delete;
+
+  // call with a current context, after the GL entry points are loaded
+  bool start(const std::filesystem::path &trace_file);
+  // restore the GL entry points and finish the file
+  bool stop();
+  bool is_recording() const noexcept { return recording; }
+
+  // mark the end of a frame; call once per frame, before swapping buffers
+  void end_frame();
+
+  uint64_t get_recorded_bytes() const noexcept { return written_bytes; }
+
+private:
+  trace_recorder() = default;
+  ~trace_recorder() noexcept;
+
+  // the hooks, defined with the command table in trace_recorder.cpp
+  struct hooks;
+
+  template <typename T> void write(const T &value) {
+    write_bytes(&value, sizeof(value));
+  }
+  void write_bytes(const void *data, size_t size);
+  // a null data pointer is recorded as such
+  void write_payload(const void *data, size_t size);
+  void flush_buffer();
+
+  // bytes glTextureSubImage* reads under the current unpack state
+  size_t image_size(GLsizei width, GLsizei height, GLsizei depth,
+                    GLenum format, GLenum type) const;
+  void track_pixel_store(GLenum pname, GLint param) noexcept;
+
+private:
+  bool recording{false};
+  bool write_failed{false};
+  std::ofstream out;
+  std::vector<std::byte> buffer;
+  uint64_t written_bytes{};
+  GLint unpack_alignment{4};
+  GLint unpack_row_length{0};
+};
+
+} // namespace opengl
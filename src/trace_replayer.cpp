@@ -0,0 +1,312 @@
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <tuple>
+#include <utility>
+
+#include "error.hpp"
+#include "trace_commands.hpp"
+#include "trace_replayer.hpp"
+
+namespace opengl {
+
+namespace {
+constexpr size_t kind_index(char kind) noexcept {
+  switch (kind) {
+  case 'b':
+    return 0;
+  case 't':
+    return 1;
+  case 'v':
+    return 2;
+  case 'f':
+    return 3;
+  case 'r':
+    return 4;
+  case 's':
+    return 5;
+  default:
+    return 6;
+  }
+}
+
+constexpr bool is_name_role(char role) noexcept {
+  return role == 'b' || role == 't' || role == 'v' || role == 'f' ||
+         role == 'r' || role == 's';
+}
+} // namespace
+
+struct trace_replayer::commands {
+  // the state of the command being replayed
+  struct call_state {
+    // the recorded name of the program argument
+    GLuint program{};
+    size_t count{};
+  };
+
+  static bool replay(trace_replayer &replayer, trace::command c) {
+    switch (c) {
+#define OPENGL_TRACE_CASE(name, kind, result, roles)                           \
+  case trace::command::name:                                                   \
+    return replay<trace::command::name>(                                       \
+        replayer, *trace::command_info<trace::command::name>::slot);
+      OPENGL_TRACE_COMMANDS(OPENGL_TRACE_CASE)
+#undef OPENGL_TRACE_CASE
+    default:
+      std::cerr << "unknown trace command:" << static_cast<int>(c)
+                << std::endl;
+      return false;
+    }
+  }
+
+  template <trace::command c, typename R, typename... A>
+  static bool replay(trace_replayer &replayer,
+                     R(APIENTRYP function)(A...)) {
+    if (function == nullptr) {
+      std::cerr << "trace command " << static_cast<int>(c)
+                << " is not supported by the context" << std::endl;
+      return false;
+    }
+    call_state state;
+    std::tuple<A...> arguments{};
+    if (!read_arguments<c>(replayer, state, arguments,
+                           std::index_sequence_for<A...>{})) {
+      return false;
+    }
+    if constexpr (std::is_void_v<R>) {
+      std::apply(function, arguments);
+      return read_outputs<c>(replayer, state);
+    } else {
+      auto const result = std::apply(function, arguments);
+      if (!read_outputs<c>(replayer, state)) {
+        return false;
+      }
+      R recorded{};
+      if (!replayer.read(recorded)) {
+        return false;
+      }
+      map_result<c>(replayer, state, recorded, result);
+      return true;
+    }
+  }
+
+  template <trace::command c, typename tuple_type, size_t... I>
+  static bool read_arguments(trace_replayer &replayer, call_state &state,
+                             tuple_type &arguments, std::index_sequence<I...>) {
+    return (read_argument<c, I>(replayer, state, std::get<I>(arguments)) &&
+            ...);
+  }
+
+  template <trace::command c, size_t I, typename T>
+  static bool read_argument(trace_replayer &replayer, call_state &state,
+                            T &argument) {
+    using info = trace::command_info<c>;
+    constexpr char role = info::roles[I];
+
+    if constexpr (role == 'O') {
+      replayer.names_out.resize(state.count);
+      argument = replayer.names_out.data();
+    } else if constexpr (role == 'x') {
+      argument = replayer.lengths.data();
+    } else if constexpr (role == 'I') {
+      const std::byte *payload = nullptr;
+      uint64_t size = 0;
+      if (!replayer.read_payload(payload, size)) {
+        return false;
+      }
+      if (payload == nullptr) {
+        argument = nullptr;
+        return true;
+      }
+      replayer.names_in.resize(size / sizeof(GLuint));
+      std::memcpy(replayer.names_in.data(), payload, size);
+      for (auto &name : replayer.names_in) {
+        name = replayer.map_name(info::kind, name);
+      }
+      argument = replayer.names_in.data();
+    } else if constexpr (role == 'd' || role == 'z') {
+      const std::byte *payload = nullptr;
+      uint64_t size = 0;
+      if (!replayer.read_payload(payload, size)) {
+        return false;
+      }
+      argument = reinterpret_cast<T>(payload);
+    } else if constexpr (role == 'S') {
+      replayer.strings.clear();
+      replayer.lengths.clear();
+      for (size_t i = 0; i < state.count; i++) {
+        const std::byte *payload = nullptr;
+        uint64_t size = 0;
+        if (!replayer.read_payload(payload, size)) {
+          return false;
+        }
+        replayer.strings.push_back(reinterpret_cast<const GLchar *>(payload));
+        replayer.lengths.push_back(static_cast<GLint>(size));
+      }
+      argument = replayer.strings.data();
+    } else if constexpr (role == 'o') {
+      uint64_t offset = 0;
+      if (!replayer.read(offset)) {
+        return false;
+      }
+      argument = reinterpret_cast<T>(static_cast<uintptr_t>(offset));
+    } else {
+      if (!replayer.read(argument)) {
+        return false;
+      }
+      if constexpr (role == 'n') {
+        state.count = static_cast<size_t>(argument);
+      } else if constexpr (role == 'p') {
+        state.program = argument;
+        if constexpr (c == trace::command::UseProgram) {
+          replayer.current_program = argument;
+        }
+        argument = replayer.map_name('p', argument);
+      } else if constexpr (is_name_role(role)) {
+        argument = replayer.map_name(role, argument);
+      } else if constexpr (role == 'l') {
+        // glUniform* have no program argument
+        constexpr bool has_program =
+            info::roles.find('p') != std::string_view::npos;
+        auto const program =
+            has_program ? state.program : replayer.current_program;
+        auto it = replayer.locations.find(
+            program_key(program, static_cast<uint32_t>(argument)));
+        if (it != replayer.locations.end()) {
+          argument = it->second;
+        }
+      } else if constexpr (role == 'k' || role == 'K') {
+        auto const &blocks =
+            role == 'k' ? replayer.uniform_blocks : replayer.storage_blocks;
+        auto it = blocks.find(program_key(state.program, argument));
+        if (it != blocks.end()) {
+          argument = it->second;
+        }
+      }
+    }
+    return true;
+  }
+
+  template <trace::command c>
+  static bool read_outputs(trace_replayer &replayer, const call_state &state) {
+    using info = trace::command_info<c>;
+    if constexpr (info::roles.find('O') != std::string_view::npos) {
+      for (size_t i = 0; i < state.count; i++) {
+        GLuint recorded = 0;
+        if (!replayer.read(recorded)) {
+          return false;
+        }
+        replayer.add_name(info::kind, recorded, replayer.names_out[i]);
+      }
+    }
+    return true;
+  }
+
+  template <trace::command c, typename R>
+  static void map_result(trace_replayer &replayer, const call_state &state,
+                         R recorded, R result) {
+    constexpr char role = trace::command_info<c>::result;
+    if constexpr (role == 'p') {
+      replayer.add_name('p', recorded, result);
+    } else if constexpr (role == 'l') {
+      replayer.locations[program_key(
+          state.program, static_cast<uint32_t>(recorded))] = result;
+    } else if constexpr (role == 'k') {
+      replayer.uniform_blocks[program_key(state.program, recorded)] = result;
+    } else if constexpr (role == 'K') {
+      replayer.storage_blocks[program_key(state.program, recorded)] = result;
+    }
+  }
+};
+
+trace_replayer::trace_replayer(const std::filesystem::path &trace_file) {
+  std::ifstream in(trace_file, std::ios::binary | std::ios::ate);
+  if (!in) {
+    throw_exception("open " + trace_file.string() + " failed");
+  }
+  data.resize(static_cast<size_t>(in.tellg()));
+  in.seekg(0);
+  in.read(reinterpret_cast<char *>(data.data()),
+          static_cast<std::streamsize>(data.size()));
+  if (!in) {
+    throw_exception("read " + trace_file.string() + " failed");
+  }
+
+  uint32_t magic = 0;
+  uint32_t version = 0;
+  if (!read(magic) || magic != trace::file_magic) {
+    throw_exception(trace_file.string() + " is not a trace");
+  }
+  if (!read(version) || version != trace::file_version) {
+    throw_exception("unsupported trace version:" + std::to_string(version));
+  }
+}
+
+bool trace_replayer::replay_frame() {
+  while (!is_finished()) {
+    trace::command c{};
+    if (!read(c)) {
+      return false;
+    }
+    if (c == trace::command::end_frame) {
+      frame_count++;
+      return true;
+    }
+    if (!commands::replay(*this, c)) {
+      std::cerr << "replay trace failed at byte " << position << std::endl;
+      return false;
+    }
+    command_count++;
+  }
+  // commands after the last end of frame
+  frame_count++;
+  return true;
+}
+
+template <typename T> bool trace_replayer::read(T &value) noexcept {
+  if (data.size() - position < sizeof(T)) {
+    std::cerr << "trace is truncated" << std::endl;
+    return false;
+  }
+  std::memcpy(&value, data.data() + position, sizeof(T));
+  position += sizeof(T);
+  return true;
+}
+
+bool trace_replayer::read_payload(const std::byte *&payload,
+                                  uint64_t &size) noexcept {
+  if (!read(size)) {
+    return false;
+  }
+  if (size == trace::null_payload) {
+    payload = nullptr;
+    size = 0;
+    return true;
+  }
+  position = (position + trace::payload_alignment - 1) /
+             trace::payload_alignment * trace::payload_alignment;
+  if (position > data.size() || data.size() - position < size) {
+    std::cerr << "trace is truncated" << std::endl;
+    return false;
+  }
+  payload = data.data() + position;
+  position += static_cast<size_t>(size);
+  return true;
+}
+
+GLuint trace_replayer::map_name(char kind, GLuint name) const noexcept {
+  if (name == 0) {
+    return 0;
+  }
+  auto const &kind_names = names[kind_index(kind)];
+  auto it = kind_names.find(name);
+  // objects created before recording started keep their names
+  return it == kind_names.end() ? name : it->second;
+}
+
+void trace_replayer::add_name(char kind, GLuint recorded, GLuint replayed) {
+  names[kind_index(kind)][recorded] = replayed;
+}
+
+} // namespace opengl
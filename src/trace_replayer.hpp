@@ -0,0 +1,79 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <unordered_map>
+#include <vector>
+
+#include "context.hpp"
+
+namespace opengl {
+
+// Plays back a trace written by trace_recorder, as fast as the driver takes
+// the commands.
+//
+// The whole trace is read into memory up front and payloads are passed to GL
+// in place, so replaying costs little beyond the GL calls themselves. Names,
+// uniform locations and block indices the recording driver returned are
+// mapped to the ones this context returns. Replay into a fresh context.
+class trace_replayer final {
+
+public:
+  explicit trace_replayer(const std::filesystem::path &trace_file);
+
+  trace_replayer(const trace_replayer &) = delete;
+  trace_replayer &operator=(const trace_replayer &) = delete;
+
+  trace_replayer(trace_replayer &&) noexcept = default;
+  trace_replayer &operator=(trace_replayer &&) noexcept = default;
+
+  ~trace_replayer() noexcept = default;
+
+  // replay the commands up to the next end of frame; false if the trace is
+  // malformed or uses a command the context lacks
+  bool replay_frame();
+  bool is_finished() const noexcept { return position == data.size(); }
+
+  size_t get_frame_count() const noexcept { return frame_count; }
+  size_t get_command_count() const noexcept { return command_count; }
+
+private:
+  // the command decoders, defined in trace_replayer.cpp
+  struct commands;
+
+  template <typename T> bool read(T &value) noexcept;
+  // a null payload is returned as nullptr
+  bool read_payload(const std::byte *&payload, uint64_t &size) noexcept;
+
+  GLuint map_name(char kind, GLuint name) const noexcept;
+  void add_name(char kind, GLuint recorded, GLuint replayed);
+
+  static uint64_t program_key(GLuint program, uint32_t value) noexcept {
+    return (static_cast<uint64_t>(program) << 32) | value;
+  }
+
+private:
+  std::vector<std::byte> data;
+  size_t position{};
+  size_t frame_count{};
+  size_t command_count{};
+
+  // recorded to replayed names, one map per kind of object
+  std::array<std::unordered_map<GLuint, GLuint>, 7> names;
+  // keyed by the recorded program and value
+  std::unordered_map<uint64_t, GLint> locations;
+  std::unordered_map<uint64_t, GLuint> uniform_blocks;
+  std::unordered_map<uint64_t, GLuint> storage_blocks;
+  // the recorded name of the program in use
+  GLuint current_program{};
+
+  // scratch space of the command being replayed
+  std::vector<GLuint> names_in;
+  std::vector<GLuint> names_out;
+  std::vector<const GLchar *> strings;
+  std::vector<GLint> lengths;
+};
+
+} // namespace opengl
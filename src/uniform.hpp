@@ -0,0 +1,160 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <gsl/gsl>
+#include <iostream>
+#include <vector>
+
+#include "error.hpp"
+#include "render_statistics.hpp"
+
+namespace opengl {
+
+class program;
+
+// The values last uploaded to a uniform variable or array through handles.
+// The program keeps one per location and forgets it when the variable is
+// set in another way, so all handles of a variable agree on its value.
+struct uniform_cache final {
+  GLsizei count{};
+  std::vector<std::byte> last_values;
+  // leading bytes whose GPU value is known to equal last_values
+  size_t known_size{};
+};
+
+// A uniform variable, or array of them, resolved once from a linked program.
+// Values go up with glProgramUniform*, so the program does not need to be in
+// use, and uploads that would not change the value are skipped. The handle is
+// invalidated by relinking the program and must not outlive it.
+template <typename T> class uniform final {
+  static_assert(std::is_same_v<T, GLint> || std::is_same_v<T, GLuint> ||
+                    std::is_same_v<T, GLfloat> ||
+                    std::is_same_v<T, glm::vec2> ||
+                    std::is_same_v<T, glm::vec3> ||
+                    std::is_same_v<T, glm::vec4> ||
+                    std::is_same_v<T, glm::mat3> ||
+                    std::is_same_v<T, glm::mat4>,
+                "unsupported uniform type");
+
+public:
+  uniform() = default;
+
+  uniform(const uniform &) = default;
+  uniform &operator=(const uniform &) = default;
+
+  uniform(uniform &&) noexcept = default;
+  uniform &operator=(uniform &&) noexcept = default;
+
+  ~uniform() noexcept = default;
+
+  bool is_valid() const noexcept { return location != -1; }
+  // number of array elements, 1 for plain variables
+  GLsizei get_count() const noexcept { return count; }
+
+  bool set(const T &value) noexcept {
+    return set(gsl::span<const T>(&value, 1));
+  }
+
+  // write values to the elements starting at first in a single call
+  bool set(gsl::span<const T> values, GLsizei first = 0) noexcept {
+    if (!is_valid()) {
+      std::cerr << "invalid uniform" << std::endl;
+      return false;
+    }
+    auto const value_count = static_cast<GLsizei>(values.size());
+    if (first < 0 || value_count == 0 || first + value_count > count) {
+      std::cerr << "uniform elements out of range" << std::endl;
+      return false;
+    }
+
+    auto const offset = static_cast<size_t>(first) * sizeof(T);
+    auto const size = values.size() * sizeof(T);
+    auto const cached = cache->last_values.data() + offset;
+    if (offset + size <= cache->known_size &&
+        std::memcmp(cached, values.data(), size) == 0) {
+      return true;
+    }
+
+    upload(location + first, value_count, values.data());
+    if (check_error()) {
+      std::cerr << "glProgramUniform failed" << std::endl;
+      // the values on the GPU are unknown now
+      cache->known_size = 0;
+      return false;
+    }
+    render_statistics::get_current().uniform_updates++;
+    std::memcpy(cached, values.data(), size);
+    // only a prefix is tracked, which covers the usual whole-array uploads
+    if (offset <= cache->known_size) {
+      cache->known_size = std::max(cache->known_size, offset + size);
+    }
+    return true;
+  }
+
+private:
+  friend class program;
+
+  uniform(GLuint program_id_, GLint location_, GLsizei count_,
+          uniform_cache &cache_)
+      : program_id{program_id_}, location{location_}, count{count_},
+        cache{&cache_} {}
+
+  void upload(GLint first_location, GLsizei value_count,
+              const T *values) const noexcept {
+    if constexpr (std::is_same_v<T, GLint>) {
+      glProgramUniform1iv(program_id, first_location, value_count, values);
+    } else if constexpr (std::is_same_v<T, GLuint>) {
+      glProgramUniform1uiv(program_id, first_location, value_count, values);
+    } else if constexpr (std::is_same_v<T, GLfloat>) {
+      glProgramUniform1fv(program_id, first_location, value_count, values);
+    } else if constexpr (std::is_same_v<T, glm::vec2>) {
+      glProgramUniform2fv(program_id, first_location, value_count,
+                          glm::value_ptr(*values));
+    } else if constexpr (std::is_same_v<T, glm::vec3>) {
+      glProgramUniform3fv(program_id, first_location, value_count,
+                          glm::value_ptr(*values));
+    } else if constexpr (std::is_same_v<T, glm::vec4>) {
+      glProgramUniform4fv(program_id, first_location, value_count,
+                          glm::value_ptr(*values));
+    } else if constexpr (std::is_same_v<T, glm::mat3>) {
+      glProgramUniformMatrix3fv(program_id, first_location, value_count,
+                                GL_FALSE, glm::value_ptr(*values));
+    } else {
+      glProgramUniformMatrix4fv(program_id, first_location, value_count,
+                                GL_FALSE, glm::value_ptr(*values));
+    }
+  }
+
+  // the GL type reported by glGetActiveUniform for T
+  static constexpr GLenum gl_type() noexcept {
+    if constexpr (std::is_same_v<T, GLint>) {
+      return GL_INT;
+    } else if constexpr (std::is_same_v<T, GLuint>) {
+      return GL_UNSIGNED_INT;
+    } else if constexpr (std::is_same_v<T, GLfloat>) {
+      return GL_FLOAT;
+    } else if constexpr (std::is_same_v<T, glm::vec2>) {
+      return GL_FLOAT_VEC2;
+    } else if constexpr (std::is_same_v<T, glm::vec3>) {
+      return GL_FLOAT_VEC3;
+    } else if constexpr (std::is_same_v<T, glm::vec4>) {
+      return GL_FLOAT_VEC4;
+    } else if constexpr (std::is_same_v<T, glm::mat3>) {
+      return GL_FLOAT_MAT3;
+    } else {
+      return GL_FLOAT_MAT4;
+    }
+  }
+
+private:
+  GLuint program_id{};
+  GLint location{-1};
+  GLsizei count{};
+  uniform_cache *cache{};
+};
+
+} // namespace opengl
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+#include "buffer.hpp"
+
+namespace opengl {
+
+// One uniform buffer that the per-draw blocks of a frame are packed into.
+//
+// Call begin_frame(), push() the blocks of all draws of the frame, upload()
+// once, then bind each draw's range with program::set_uniform_block_range.
+// Ranges pushed after the upload cannot be bound, so that a frame costs a
+// single upload. The buffer is orphaned at the start of every frame so that
+// the previous frame's draws are not waited for.
+class uniform_arena final : public buffer {
+
+public:
+  struct range {
+    GLintptr offset;
+    GLsizeiptr size;
+  };
+
+public:
+  explicit uniform_arena(size_t capacity_) : buffer(GL_UNIFORM_BUFFER) {
+    GLint alignment_ = 0;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment_);
+    if (check_error() || alignment_ <= 0) {
+      throw_exception("get GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT failed");
+    }
+    alignment = static_cast<size_t>(alignment_);
+    shadow.resize(capacity_);
+    if (!alloc(capacity_, GL_STREAM_DRAW)) {
+      throw_exception("alloc failed");
+    }
+  }
+
+  uniform_arena(const uniform_arena &) = delete;
+  uniform_arena &operator=(const uniform_arena &) = delete;
+
+  uniform_arena(uniform_arena &&) noexcept = default;
+  uniform_arena &operator=(uniform_arena &&) noexcept = default;
+
+  ~uniform_arena() override = default;
+
+  // drop the ranges of the previous frame
+  void begin_frame() noexcept {
+    used_size = 0;
+    uploaded_size = 0;
+    orphan = true;
+  }
+
+  // Append data at the next aligned offset. The arena grows when it is full;
+  // the buffer is then reallocated at the next upload.
+  template <typename T> range push(const T &data) {
+    static_assert(std::is_trivially_copyable_v<T>,
+                  "uniform data must be trivially copyable");
+    auto const offset = (used_size + alignment - 1) / alignment * alignment;
+    if (offset + sizeof(T) > shadow.size()) {
+      shadow.resize(std::max(shadow.size() * 2, offset + sizeof(T)));
+    }
+    std::memcpy(shadow.data() + offset, &data, sizeof(T));
+    used_size = offset + sizeof(T);
+    return {static_cast<GLintptr>(offset), static_cast<GLsizeiptr>(sizeof(T))};
+  }
+
+  // upload what has been pushed in this frame
+  bool upload() noexcept {
+    if (shadow.size() > get_size() || orphan) {
+      if (!alloc(shadow.size(), GL_STREAM_DRAW)) {
+        return false;
+      }
+      orphan = false;
+      // the new storage holds nothing yet
+      uploaded_size = 0;
+    }
+    if (uploaded_size >= used_size) {
+      return true;
+    }
+    if (!write_part(gsl::span<const std::byte>(shadow.data() + uploaded_size,
+                                               used_size - uploaded_size),
+                    static_cast<GLintptr>(uploaded_size))) {
+      return false;
+    }
+    uploaded_size = used_size;
+    return true;
+  }
+
+  bool use(GLuint binding_point, const range &r) noexcept {
+    if (static_cast<size_t>(r.offset + r.size) > uploaded_size) {
+      std::cerr << "uniform arena range was not uploaded in this frame"
+                << std::endl;
+      return false;
+    }
+    glBindBufferRange(GL_UNIFORM_BUFFER, binding_point, *buffer_id, r.offset,
+                      r.size);
+    if (check_error()) {
+      std::cerr << "glBindBufferRange failed" << std::endl;
+      return false;
+    }
+    return true;
+  }
+
+private:
+  std::vector<std::byte> shadow;
+  size_t alignment{};
+  size_t used_size{};
+  size_t uploaded_size{};
+  bool orphan{false};
+};
+
+} // namespace opengl
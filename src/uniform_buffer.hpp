@@ -1,16 +1,47 @@
 #pragma once
 
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <map>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
 #include "buffer.hpp"
+#include "std140.hpp"
 
 namespace opengl {
 
+// A uniform block's buffer with a copy of its contents in system memory.
+// Writes only change the copy and extend a dirty byte range, which use() or
+// flush() uploads in a single call.
 class uniform_buffer final : public buffer {
 
 public:
-  uniform_buffer(size_t buffer_size) : buffer(GL_UNIFORM_BUFFER) {
+  // a member as reflected from a linked program
+  struct member_layout {
+    GLint offset;
+    GLenum type;
+    // array size, 1 for non-array members
+    GLint count;
+    GLint array_stride;
+    bool row_major;
+  };
+  using member_layouts = std::map<std::string, member_layout, std::less<>>;
+
+public:
+  explicit uniform_buffer(size_t buffer_size,
+                          const member_layouts &layouts = {})
+      : buffer(GL_UNIFORM_BUFFER), shadow(buffer_size),
+        dirty_end{buffer_size} {
     if (!alloc(buffer_size)) {
       throw_exception("alloc failed");
     }
+    for (auto const &[name, layout] : layouts) {
+      members.emplace(name, member{layout, false});
+    }
   }
 
   uniform_buffer(const uniform_buffer &) = delete;
@@ -22,10 +53,150 @@ public:
   ~uniform_buffer() override = default;
 
   template <typename T> bool write(const T &data, GLintptr offset) noexcept {
-    return write_part(gsl::span<const T>{&data, 1}, offset);
+    static_assert(std::is_trivially_copyable_v<T>,
+                  "uniform data must be trivially copyable");
+    if (offset < 0 ||
+        static_cast<size_t>(offset) + sizeof(T) > shadow.size()) {
+      std::cerr << "uniform buffer write out of range" << std::endl;
+      return false;
+    }
+    auto const begin = static_cast<size_t>(offset);
+    std::memcpy(shadow.data() + begin, &data, sizeof(T));
+    dirty_begin = std::min(dirty_begin, begin);
+    dirty_end = std::max(dirty_end, begin + sizeof(T));
+    return true;
+  }
+
+  // write a member by the name the program reports for it; T has to be the
+  // reflected type of the member
+  template <typename T>
+  bool write_member(std::string_view member_name, const T &data) noexcept {
+    static_assert(is_std140_type_v<T>, "unsupported uniform block member type");
+    auto it = members.find(member_name);
+    if (it == members.end()) {
+      std::cerr << "no uniform block member:" << member_name << std::endl;
+      return false;
+    }
+    auto const &layout = it->second.layout;
+    if (layout.type != std140_traits<T>::type || layout.row_major) {
+      std::cerr << "uniform block member type mismatch:" << member_name
+                << std::endl;
+      return false;
+    }
+    if (!write(data, layout.offset)) {
+      return false;
+    }
+    it->second.assigned = true;
+    return true;
+  }
+
+  // write a struct mirroring the whole block
+  template <typename T, size_t N>
+  bool write_block(const T &data, const std140_layout<N> &layout) noexcept {
+    if (!match_layout(layout)) {
+      return false;
+    }
+    if (!write(data, 0)) {
+      return false;
+    }
+    for (auto &[_, m] : members) {
+      m.assigned = true;
+    }
+    return true;
+  }
+
+  // Compare a struct layout with the reflected members. Each layout is only
+  // compared once; its address identifies it afterwards.
+  template <size_t N>
+  bool match_layout(const std140_layout<N> &layout) noexcept {
+    if (matched_layout == &layout) {
+      return true;
+    }
+    if (layout.size > shadow.size()) {
+      std::cerr << "uniform block struct is larger than the block" << std::endl;
+      return false;
+    }
+    for (auto const &declared : layout.members) {
+      auto it = members.find(std::string_view(declared.name));
+      if (it == members.end()) {
+        // arrays are reported as "name[0]"
+        it = members.find(std::string(declared.name) + "[0]");
+      }
+      if (it == members.end()) {
+        std::cerr << "no uniform block member:" << declared.name << std::endl;
+        return false;
+      }
+      auto const &reflected = it->second.layout;
+      if (reflected.offset != static_cast<GLint>(declared.offset) ||
+          reflected.type != declared.type ||
+          reflected.count != declared.count ||
+          (declared.count > 1 &&
+           reflected.array_stride !=
+               static_cast<GLint>(declared.array_stride)) ||
+          reflected.row_major) {
+        std::cerr << "uniform block member layout mismatch:" << declared.name
+                  << std::endl;
+        return false;
+      }
+    }
+    if (layout.members.size() != members.size()) {
+      std::cerr << "uniform block struct does not declare every member"
+                << std::endl;
+      return false;
+    }
+    matched_layout = &layout;
+    return true;
+  }
+
+  // whether the buffer was made for a block of this size and these members,
+  // so that another program can share it
+  bool has_layout(size_t buffer_size,
+                  const member_layouts &layouts) const noexcept {
+    if (buffer_size != shadow.size() || layouts.size() != members.size()) {
+      return false;
+    }
+    return std::equal(
+        layouts.begin(), layouts.end(), members.begin(),
+        [](auto const &reflected, auto const &known) {
+          auto const &[name, layout] = reflected;
+          auto const &known_layout = known.second.layout;
+          return name == known.first && layout.offset == known_layout.offset &&
+                 layout.type == known_layout.type &&
+                 layout.count == known_layout.count &&
+                 layout.array_stride == known_layout.array_stride &&
+                 layout.row_major == known_layout.row_major;
+        });
+  }
+
+  bool has_member(std::string_view member_name) const noexcept {
+    return members.find(member_name) != members.end();
+  }
+
+  // whether the member has been written by name
+  bool is_assigned(std::string_view member_name) const noexcept {
+    auto it = members.find(member_name);
+    return it != members.end() && it->second.assigned;
+  }
+
+  // upload the dirty range of the copy
+  bool flush() noexcept {
+    if (dirty_begin >= dirty_end) {
+      return true;
+    }
+    if (!write_part(gsl::span<const std::byte>(shadow.data() + dirty_begin,
+                                               dirty_end - dirty_begin),
+                    static_cast<GLintptr>(dirty_begin))) {
+      return false;
+    }
+    dirty_begin = shadow.size();
+    dirty_end = 0;
+    return true;
   }
 
   bool use(GLuint binding_point) noexcept {
+    if (!flush()) {
+      return false;
+    }
     if (!bind()) {
       return false;
     }
@@ -37,6 +208,20 @@ public:
     }
     return true;
   }
+
+private:
+  struct member {
+    member_layout layout;
+    bool assigned;
+  };
+
+private:
+  std::vector<std::byte> shadow;
+  std::map<std::string, member, std::less<>> members;
+  // the whole buffer is dirty at first, so that it starts out zeroed
+  size_t dirty_begin{};
+  size_t dirty_end{};
+  const void *matched_layout{};
 };
 
 } // namespace opengl
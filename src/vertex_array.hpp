@@ -1,8 +1,13 @@
 #pragma once
 
 #include <iostream>
+#include <memory>
 
+#include "buffer.hpp"
+#include "context.hpp"
 #include "error.hpp"
+#include "render_statistics.hpp"
+#include "vertex_layout.hpp"
 
 namespace opengl {
 
@@ -10,11 +15,18 @@ class vertex_array final {
 
 public:
   explicit vertex_array(bool use_after_create = true) {
-    glGenVertexArrays(1, vertex_array_id.get());
-
-    if (check_error()) {
-      throw_exception("glGenVertexArrays failed");
+    if constexpr (opengl::context::gl_minor_version < 5) {
+      glGenVertexArrays(1, vertex_array_id.get());
+      if (check_error()) {
+        throw_exception("glGenVertexArrays failed");
+      }
+    } else {
+      glCreateVertexArrays(1, vertex_array_id.get());
+      if (check_error()) {
+        throw_exception("glCreateVertexArrays failed");
+      }
     }
+    render_statistics::get_current().objects_created++;
     if (use_after_create && !use()) {
       throw_exception("can't use vertex_array");
     }
@@ -31,6 +43,73 @@ public:
   bool use() noexcept { return bind(*vertex_array_id); }
   bool unuse() noexcept { return bind(0); }
 
+  // The functions below describe the layout and attach buffers without
+  // binding the vertex array. They need OpenGL 4.5.
+
+  bool set_attribute_format(const opengl::vertex_attribute &attribute,
+                            GLuint binding_index) noexcept {
+    glEnableVertexArrayAttrib(*vertex_array_id, attribute.index);
+    if (check_error()) {
+      std::cerr << "glEnableVertexArrayAttrib failed" << std::endl;
+      return false;
+    }
+    glVertexArrayAttribFormat(*vertex_array_id, attribute.index,
+                              attribute.size, attribute.type,
+                              attribute.normalized, attribute.offset);
+    if (check_error()) {
+      std::cerr << "glVertexArrayAttribFormat failed" << std::endl;
+      return false;
+    }
+    glVertexArrayAttribBinding(*vertex_array_id, attribute.index,
+                               binding_index);
+    if (check_error()) {
+      std::cerr << "glVertexArrayAttribBinding failed" << std::endl;
+      return false;
+    }
+    return true;
+  }
+
+  // source every attribute of layout from the buffer at binding_index
+  template <size_t N>
+  bool set_layout(const opengl::vertex_layout<N> &layout,
+                  GLuint binding_index, GLuint divisor = 0) noexcept {
+    for (auto const &attribute : layout.attributes) {
+      if (!set_attribute_format(attribute, binding_index)) {
+        return false;
+      }
+    }
+    return divisor == 0 || set_binding_divisor(binding_index, divisor);
+  }
+
+  bool set_binding_divisor(GLuint binding_index, GLuint divisor) noexcept {
+    glVertexArrayBindingDivisor(*vertex_array_id, binding_index, divisor);
+    if (check_error()) {
+      std::cerr << "glVertexArrayBindingDivisor failed" << std::endl;
+      return false;
+    }
+    return true;
+  }
+
+  bool set_vertex_buffer(GLuint binding_index, const opengl::buffer &buffer,
+                         GLintptr offset, GLsizei stride) noexcept {
+    glVertexArrayVertexBuffer(*vertex_array_id, binding_index,
+                              *buffer.buffer_id, offset, stride);
+    if (check_error()) {
+      std::cerr << "glVertexArrayVertexBuffer failed" << std::endl;
+      return false;
+    }
+    return true;
+  }
+
+  bool set_element_buffer(const opengl::buffer &buffer) noexcept {
+    glVertexArrayElementBuffer(*vertex_array_id, *buffer.buffer_id);
+    if (check_error()) {
+      std::cerr << "glVertexArrayElementBuffer failed" << std::endl;
+      return false;
+    }
+    return true;
+  }
+
 private:
   bool bind(GLuint id) noexcept {
     glBindVertexArray(id);
@@ -38,11 +117,16 @@ private:
       std::cerr << "glBindVertexArray failed" << std::endl;
       return false;
     }
+    render_statistics::get_current().vertex_array_binds++;
     return true;
   }
 
 private:
   std::shared_ptr<GLuint> vertex_array_id{new GLuint(0), [](GLuint *ptr) {
+                                            if (*ptr != 0) {
+                                              render_statistics::get_current()
+                                                  .objects_deleted++;
+                                            }
                                             glDeleteVertexArrays(1, ptr);
                                             delete ptr;
                                           }};
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+#include "glad/glad.h"
+
+namespace opengl {
+
+struct vertex_attribute {
+  GLuint index;
+  GLint size;
+  GLenum type;
+  GLboolean normalized;
+  GLuint offset;
+};
+
+// The attributes of one vertex buffer binding, declared next to the vertex
+// struct they describe so that the layout is known at compile time.
+template <size_t N> struct vertex_layout {
+  GLsizei stride;
+  std::array<vertex_attribute, N> attributes;
+
+  // FNV-1a over every field; equal layouts share vertex arrays and can be
+  // batched together
+  constexpr uint64_t hash() const noexcept {
+    uint64_t value = 14695981039346656037ull;
+    auto mix = [&value](uint64_t field) {
+      for (int i = 0; i < 8; i++) {
+        value ^= (field >> (i * 8)) & 0xff;
+        value *= 1099511628211ull;
+      }
+    };
+    mix(static_cast<uint64_t>(stride));
+    for (auto const &attribute : attributes) {
+      mix(attribute.index);
+      mix(static_cast<uint64_t>(attribute.size));
+      mix(attribute.type);
+      mix(attribute.normalized);
+      mix(attribute.offset);
+    }
+    return value;
+  }
+};
+
+template <typename T> struct vertex_attribute_traits;
+template <> struct vertex_attribute_traits<GLfloat> {
+  static constexpr GLint size = 1;
+  static constexpr GLenum type = GL_FLOAT;
+};
+template <> struct vertex_attribute_traits<glm::vec2> {
+  static constexpr GLint size = 2;
+  static constexpr GLenum type = GL_FLOAT;
+};
+template <> struct vertex_attribute_traits<glm::vec3> {
+  static constexpr GLint size = 3;
+  static constexpr GLenum type = GL_FLOAT;
+};
+template <> struct vertex_attribute_traits<glm::vec4> {
+  static constexpr GLint size = 4;
+  static constexpr GLenum type = GL_FLOAT;
+};
+
+// attribute index reads a member of type T at offset, e.g.
+// attribute_of<glm::vec3>(0, offsetof(vertex, position))
+template <typename T>
+constexpr vertex_attribute attribute_of(GLuint index, size_t offset,
+                                        bool normalized = false) noexcept {
+  return {index, vertex_attribute_traits<T>::size,
+          vertex_attribute_traits<T>::type,
+          static_cast<GLboolean>(normalized ? GL_TRUE : GL_FALSE),
+          static_cast<GLuint>(offset)};
+}
+
+template <typename vertex_type, typename... attribute_types>
+constexpr vertex_layout<sizeof...(attribute_types)>
+make_vertex_layout(attribute_types... attributes) noexcept {
+  return {static_cast<GLsizei>(sizeof(vertex_type)), {{attributes...}}};
+}
+
+// a per-instance mat4 occupying four consecutive locations
+constexpr vertex_layout<4> mat4_layout(GLuint first_location) noexcept {
+  return make_vertex_layout<glm::mat4>(
+      attribute_of<glm::vec4>(first_location, 0),
+      attribute_of<glm::vec4>(first_location + 1, sizeof(glm::vec4)),
+      attribute_of<glm::vec4>(first_location + 2, 2 * sizeof(glm::vec4)),
+      attribute_of<glm::vec4>(first_location + 3, 3 * sizeof(glm::vec4)));
+}
+
+constexpr uint64_t combine_layout_hashes(uint64_t lhs, uint64_t rhs) noexcept {
+  return lhs ^ (rhs + 0x9e3779b97f4a7c15ull + (lhs << 6) + (lhs >> 2));
+}
+
+} // namespace opengl
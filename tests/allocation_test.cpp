@@ -0,0 +1,158 @@
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "camera.hpp"
+#include "mesh.hpp"
+#include "model.hpp"
+#include "null_backend.hpp"
+#include "program.hpp"
+#include "synthetic_assets.hpp"
+
+namespace {
+std::atomic<size_t> allocation_count{};
+
+void *allocate(size_t size, size_t alignment) {
+  allocation_count.fetch_add(1, std::memory_order_relaxed);
+  if (size == 0) {
+    size = 1;
+  }
+  void *memory = nullptr;
+  if (alignment <= alignof(std::max_align_t)) {
+    memory = std::malloc(size);
+  } else {
+    memory = std::aligned_alloc(alignment,
+                                (size + alignment - 1) / alignment * alignment);
+  }
+  if (memory == nullptr) {
+    throw std::bad_alloc();
+  }
+  return memory;
+}
+} // namespace
+
+void *operator new(size_t size) {
+  return allocate(size, alignof(std::max_align_t));
+}
+void *operator new(size_t size, std::align_val_t alignment) {
+  return allocate(size, static_cast<size_t>(alignment));
+}
+void operator delete(void *memory) noexcept { std::free(memory); }
+void operator delete(void *memory, std::align_val_t) noexcept {
+  std::free(memory);
+}
+void operator delete(void *memory, size_t) noexcept { std::free(memory); }
+void operator delete(void *memory, size_t, std::align_val_t) noexcept {
+  std::free(memory);
+}
+
+namespace {
+using texture_variable_names =
+    std::map<opengl::texture_2D::type, std::vector<std::string>>;
+
+// calls operation a few times to create what is created lazily, then fails
+// if further calls allocate
+bool check_no_allocation(const std::string &name,
+                         const std::function<bool()> &operation) {
+  constexpr size_t warm_up_calls = 3;
+  constexpr size_t checked_calls = 100;
+  for (size_t i = 0; i < warm_up_calls; i++) {
+    if (!operation()) {
+      std::cerr << name << " failed" << std::endl;
+      return false;
+    }
+  }
+  auto const before = allocation_count.load();
+  for (size_t i = 0; i < checked_calls; i++) {
+    if (!operation()) {
+      std::cerr << name << " failed" << std::endl;
+      return false;
+    }
+  }
+  auto const allocations = allocation_count.load() - before;
+  if (allocations != 0) {
+    std::cerr << name << " allocated " << allocations << " times in "
+              << checked_calls << " calls after warming up" << std::endl;
+    return false;
+  }
+  std::cout << name << " allocates nothing" << std::endl;
+  return true;
+}
+
+bool run(const std::filesystem::path &model_file) {
+  opengl::null_backend::set_program_interface(
+      benchmark::make_program_interface(1, 0));
+  opengl::program prog;
+  auto const sources = benchmark::make_shader_sources(1, 0);
+  if (!prog.attach_shader(GL_VERTEX_SHADER, sources.vertex) ||
+      !prog.attach_shader(GL_FRAGMENT_SHADER, sources.fragment)) {
+    return false;
+  }
+  opengl::texture_2D texture(4, 4, GL_RGBA8);
+  if (!prog.set_uniform("scale", 1.0f) || !prog.set_uniform("mode", 0) ||
+      !prog.set_uniform("tint", glm::vec3(1.0f)) ||
+      !prog.set_uniform("offset", glm::vec3(0.0f)) ||
+      !prog.set_uniform("cell", 0, 0, 0) ||
+      !prog.set_uniform("model", glm::mat4(1.0f)) ||
+      !prog.set_uniform("view_projection", glm::mat4(1.0f)) ||
+      !prog.set_uniform("texture0", texture)) {
+    return false;
+  }
+
+  opengl::mesh quad(
+      {{{-0.5f, 0, -0.5f}, {0, 1, 0}, {0, 0}},
+       {{0.5f, 0, -0.5f}, {0, 1, 0}, {1, 0}},
+       {{-0.5f, 0, 0.5f}, {0, 1, 0}, {0, 1}},
+       {{0.5f, 0, 0.5f}, {0, 1, 0}, {1, 1}}},
+      {0, 2, 1, 1, 2, 3}, {{opengl::texture_2D::type::diffuse, {texture}}});
+  texture_variable_names const variable_names{
+      {opengl::texture_2D::type::diffuse, {"texture0"}}};
+
+  opengl::model::import_config config;
+  config.lod_count = 2;
+  opengl::model scene(model_file, config);
+  scene.set_model_matrix_variable_name("model");
+  opengl::camera view_camera({0, 2, 4}, {0, 1, 0}, {0, -0.5f, -1});
+
+  bool succeeded = true;
+  succeeded &= check_no_allocation("program::use", [&] { return prog.use(); });
+  succeeded &= check_no_allocation(
+      "mesh::draw", [&] { return quad.draw(prog, variable_names); });
+  succeeded &= check_no_allocation("model::draw", [&] {
+    return scene.draw(prog, texture_variable_names{});
+  });
+  succeeded &= check_no_allocation("model::draw with camera", [&] {
+    return scene.draw(prog, texture_variable_names{}, view_camera, 640, 480);
+  });
+  return succeeded;
+}
+} // namespace
+
+// Checks that the per-frame draw path allocates nothing once warmed up, on
+// the null backend.
+int main() {
+  opengl::null_backend::install();
+
+  std::error_code error;
+  auto const model_file = std::filesystem::temp_directory_path(error) /
+                          "opengl_cpp_allocation_test.gltf";
+  if (error || !benchmark::write_grid_model(model_file, 8, 2, 3)) {
+    return EXIT_FAILURE;
+  }
+  bool succeeded = false;
+  try {
+    succeeded = run(model_file);
+  } catch (const std::exception &e) {
+    std::cerr << "allocation test failed:" << e.what() << std::endl;
+  }
+  std::filesystem::remove(model_file, error);
+  return succeeded ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,87 @@
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <numeric>
+#include <vector>
+
+#include "context.hpp"
+#include "profiler.hpp"
+#include "trace_replayer.hpp"
+
+// Replays a trace recorded by opengl::trace_recorder without vsync and
+// reports how long the frames took.
+int main(int argc, char **argv) {
+  if (argc != 2 && argc != 4) {
+    std::cerr << "usage:" << argv[0] << " trace_file [width height]"
+              << std::endl;
+    return EXIT_FAILURE;
+  }
+  int width = 1280;
+  int height = 720;
+  if (argc == 4) {
+    width = std::atoi(argv[2]);
+    height = std::atoi(argv[3]);
+  }
+
+  auto window = opengl::context::create(width, height, "trace replay");
+  if (!window) {
+    return EXIT_FAILURE;
+  }
+  glfwSwapInterval(0);
+
+  try {
+    opengl::trace_replayer replayer(argv[1]);
+
+    auto &profiler = opengl::profiler::instance();
+    profiler.set_enabled(true);
+    profiler.set_sample_window(std::numeric_limits<size_t>::max());
+
+    using clock = std::chrono::steady_clock;
+    auto milliseconds = [](clock::duration d) {
+      return std::chrono::duration<double, std::milli>(d).count();
+    };
+    std::vector<double> frame_milliseconds;
+    auto const replay_begin = clock::now();
+    while (!replayer.is_finished()) {
+      auto const frame_begin = clock::now();
+      {
+        opengl::profiler::zone zone("frame");
+        if (!replayer.replay_frame()) {
+          return EXIT_FAILURE;
+        }
+      }
+      frame_milliseconds.push_back(milliseconds(clock::now() - frame_begin));
+      glfwSwapBuffers(*window);
+      glfwPollEvents();
+      profiler.end_frame();
+    }
+    glFinish();
+    auto const total_milliseconds = milliseconds(clock::now() - replay_begin);
+    profiler.end_frame();
+
+    std::cout << "frames:" << replayer.get_frame_count()
+              << " commands:" << replayer.get_command_count()
+              << " total:" << total_milliseconds << "ms" << std::endl;
+    if (!frame_milliseconds.empty()) {
+      auto sorted = frame_milliseconds;
+      std::sort(sorted.begin(), sorted.end());
+      std::cout << "CPU per frame avg:"
+                << std::accumulate(sorted.begin(), sorted.end(), 0.0) /
+                       static_cast<double>(sorted.size())
+                << "ms median:" << sorted[sorted.size() / 2]
+                << "ms max:" << sorted.back() << "ms" << std::endl;
+    }
+    auto const statistics = profiler.get_statistics();
+    if (auto it = statistics.find("frame"); it != statistics.end()) {
+      std::cout << "GPU per frame avg:" << it->second.gpu_milliseconds << "ms"
+                << std::endl;
+    }
+    profiler.clear();
+  } catch (const std::exception &) {
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}